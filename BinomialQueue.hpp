@@ -1,50 +1,270 @@
 #if !defined(BINOMIAL_QUEUE_HPP)
 #define BINOMIAL_QUEUE_HPP
 
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+template <typename T>
+class BinomialQueue;
+
+template <typename T>
+class BinomialTree;
+
+// Link two trees of the same rank, the one with the larger key goes under the other
+template <typename T>
+BinomialTree<T>* Merge(BinomialTree<T>* T1, BinomialTree<T>* T2);
+
 template <typename T>
 class BinomialTree {
 public:
 	friend class BinomialQueue <T>;
+	friend BinomialTree* Merge<T>(BinomialTree* T1, BinomialTree* T2);
 	using PtrBinomialTree = BinomialTree<T>*;
 	BinomialTree();
 	BinomialTree(const T& key);
 	~BinomialTree();
 
-	T getKey();
+	const T& getKey() const;
 
 private:
 	T key;
-	PtrBinomialTree left_child;
+	PtrBinomialTree left_child;		// Children are kept in decreasing rank
 	PtrBinomialTree next_sibling;
 };
 
-template <typename T>
-BinomialTree<T>::PtrBinomialTree Merge(BinomialTree<T>::PtrBinomialTree T1, BinomialTree<T>::PtrBinomialTree T2);
-
 template <typename T>
 class BinomialQueue {
 public:
-	BinomialQueue();	// By default generate a Queue of 30
-	BinomialQueue(int capacity);
-	BinomialQueue(int capacity, const T& key);
-	BinomialQueue(int capacity, BinomialTree<T>* old_tree);
+	BinomialQueue();
+	BinomialQueue(int capacity);	// Reserve room for trees of rank < capacity
+	BinomialQueue(const BinomialQueue&) = delete;
+	BinomialQueue& operator=(const BinomialQueue&) = delete;
 
 	int getSize();
 	void Insert(const T& key);
 	void DeleteMin();
-	T Top();
+	const T& Top();
+
+	// Move all the trees of Q into this queue in O(log n), Q is left empty
+	void Meld(BinomialQueue&& Q);
+	// Meld the queues in [first, last) into *first, pairwise in a reduction tree spread over threads
+	template <typename Iterator>
+	static void MeldAll(Iterator first, Iterator last, int threads = std::thread::hardware_concurrency());
 
 	~BinomialQueue();
 private:
 	using PtrNode = BinomialTree<T>*;
-	PtrNode* Queue;
-	int size;
+	std::vector<PtrNode> Queue;		// Queue[i] is the tree of rank i, or nullptr
+	int size;						// Number of keys
+	int min_index;					// Rank of the tree whose root is the minimum, -1 if empty
 
-	// Merge a smaller Binomial Queue Q into this one
-	// Merge Q into this one, Q WILL BE DELETED AFTER THIS
-	void Merge(BinomialQueue<T>* Q);
+	// Put a tree of the given rank into the queue, carrying upwards. Returns where it ends up.
+	int AddTree(PtrNode tree, int rank);
+	// Merge trees[i] (of rank i, or nullptr) for i < count into the queue in one carry pass
+	void MergeTrees(PtrNode* trees, int count);
+	void FindMin();
+	void DeleteTree(PtrNode tree);
 };
 
-#endif // BINOMIAL_QUEUE_HPP
+// Implementation below
+
+template <typename T>
+BinomialTree<T>* Merge(BinomialTree<T>* T1, BinomialTree<T>* T2) {
+	if (T2->key < T1->key) {
+		BinomialTree<T>* tmp = T1;
+		T1 = T2;
+		T2 = tmp;
+	}
+	T2->next_sibling = T1->left_child;
+	T1->left_child = T2;
+	return T1;
+}
+
+template <typename T>
+const T& BinomialTree<T>::getKey() const {
+	return key;
+}
+
+template <typename T>
+BinomialTree<T>::BinomialTree() : left_child(nullptr), next_sibling(nullptr) {}
+
+template <typename T>
+BinomialTree<T>::BinomialTree(const T& key) : key(key), left_child(nullptr), next_sibling(nullptr) {}
+
+template <typename T>
+BinomialTree<T>::~BinomialTree() {}
+
+template <typename T>
+BinomialQueue<T>::BinomialQueue() : BinomialQueue(30) {}
+
+template <typename T>
+BinomialQueue<T>::BinomialQueue(int capacity) : Queue(capacity > 0 ? capacity : 1, nullptr), size(0), min_index(-1) {}
+
+template <typename T>
+BinomialQueue<T>::~BinomialQueue() {
+	for (PtrNode tree : Queue) {
+		DeleteTree(tree);
+	}
+}
+
+template <typename T>
+void BinomialQueue<T>::DeleteTree(PtrNode tree) {
+	while (tree != nullptr) {
+		PtrNode next = tree->next_sibling;
+		DeleteTree(tree->left_child);	// Recursion depth is bounded by the rank
+		delete tree;
+		tree = next;
+	}
+}
+
+template <typename T>
+int BinomialQueue<T>::getSize() {
+	return size;
+}
+
+template <typename T>
+int BinomialQueue<T>::AddTree(PtrNode tree, int rank) {
+	while (true) {
+		if (rank == static_cast<int>(Queue.size())) {
+			Queue.push_back(nullptr);
+		}
+		if (Queue[rank] == nullptr) {
+			Queue[rank] = tree;
+			return rank;
+		}
+		tree = Merge(Queue[rank], tree);
+		Queue[rank] = nullptr;
+		rank++;
+	}
+}
+
+template <typename T>
+void BinomialQueue<T>::Insert(const T& key) {
+	int rank = AddTree(new BinomialTree<T>(key), 0);
+	size++;
+	// Only the trees of rank 0 ... rank - 1 were linked, if the minimum was one of them
+	// its root is still the root of the new tree (or an equal key is)
+	if (min_index == -1 || min_index < rank || Queue[rank]->key < Queue[min_index]->key) {
+		min_index = rank;
+	}
+}
+
+template <typename T>
+const T& BinomialQueue<T>::Top() {
+	// Did not check underflow!
+	return Queue[min_index]->key;
+}
+
+template <typename T>
+void BinomialQueue<T>::MergeTrees(PtrNode* trees, int count) {
+	PtrNode carry = nullptr;
+	for (int i = 0; i < count || carry != nullptr; i++) {
+		if (i == static_cast<int>(Queue.size())) {
+			Queue.push_back(nullptr);
+		}
+		auto T1 = Queue[i];
+		auto T2 = i < count ? trees[i] : nullptr;
+		int flag = 4 * (carry != nullptr) + 2 * (T1 != nullptr) + (T2 != nullptr);
+		switch (flag) {
+			case 0:
+			case 1:
+				Queue[i] = T2;
+				break;
+			case 2:
+				Queue[i] = T1;
+				break;
+			case 3:	// 11
+			case 7:
+				Queue[i] = carry;
+				carry = Merge(T1, T2);
+				break;
+			case 4:
+				Queue[i] = carry;
+				carry = nullptr;
+				break;
+			case 5:
+				Queue[i] = nullptr;
+				carry = Merge(carry, T2);
+				break;
+			case 6:
+				Queue[i] = nullptr;
+				carry = Merge(carry, T1);
+				break;
+		}
+	}
+	FindMin();
+}
+
+template <typename T>
+void BinomialQueue<T>::Meld(BinomialQueue&& Q) {
+	if (&Q == this || Q.size == 0) {
+		return;
+	}
+	MergeTrees(Q.Queue.data(), Q.Queue.size());
+	size += Q.size;
+	std::fill(Q.Queue.begin(), Q.Queue.end(), nullptr);
+	Q.size = 0;
+	Q.min_index = -1;
+}
+
+template <typename T>
+template <typename Iterator>
+void BinomialQueue<T>::MeldAll(Iterator first, Iterator last, int threads) {
+	int count = last - first;
+	for (int stride = 1; stride < count; stride *= 2) {
+		// Pairs (i, i + stride) for i = 0, 2 * stride, ... are independent of each other
+		int pairs = (count - stride + 2 * stride - 1) / (2 * stride);
+		int workers = std::max(1, std::min(threads, pairs));
+		auto meld_pairs = [first, stride, pairs, workers](int worker) {
+			for (int p = worker; p < pairs; p += workers) {
+				int i = p * 2 * stride;
+				first[i].Meld(std::move(first[i + stride]));
+			}
+		};
+		if (workers == 1) {
+			meld_pairs(0);
+			continue;
+		}
+		std::vector<std::thread> pool;
+		for (int w = 0; w < workers; w++) {
+			pool.emplace_back(meld_pairs, w);
+		}
+		for (auto& worker : pool) {
+			worker.join();
+		}
+	}
+}
+
+template <typename T>
+void BinomialQueue<T>::FindMin() {
+	min_index = -1;
+	for (int i = 0; i < static_cast<int>(Queue.size()); i++) {
+		if (Queue[i] != nullptr && (min_index == -1 || Queue[i]->key < Queue[min_index]->key)) {
+			min_index = i;
+		}
+	}
+}
 
+template <typename T>
+void BinomialQueue<T>::DeleteMin() {
+	if (size <= 0) {
+		return;
+	}
+	PtrNode old_root = Queue[min_index];
+	int rank = min_index;
+	Queue[min_index] = nullptr;
+
+	// The children have ranks rank - 1, ..., 0, lay them out by rank and merge them back
+	PtrNode children[64];
+	for (PtrNode itr = old_root->left_child, nxt; itr != nullptr; itr = nxt) {
+		nxt = itr->next_sibling;
+		itr->next_sibling = nullptr;
+		children[--rank] = itr;
+	}
+	delete old_root;
+	size--;
+	MergeTrees(children, min_index);
+}
 
+#endif // BINOMIAL_QUEUE_HPP
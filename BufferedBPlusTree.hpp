@@ -0,0 +1,432 @@
+#if !defined(BUFFERED_BPLUS_TREE_HPP)
+#define BUFFERED_BPLUS_TREE_HPP
+
+#include "BPlusTree.hpp"
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+
+// A BPlusTree internal node plus the messages waiting to go down to each child
+template <typename K, typename V, int Order, int BufferSize>
+class BufferedBPlusInternal : public BPlusInternal<K, V, Order> {
+public:
+    friend class BufferedBPlusTree<K, V, Order, BufferSize>;
+protected:
+    struct Message {
+        K key;
+        V value;
+        bool erase;     // Tombstone, value is unused
+    };
+    std::vector<Message> pending[Order + 2];   // Messages for child[i] in arrival order, newer than anything below
+    int buffered = 0;                           // Messages in all of pending
+};
+
+// Write optimized B+ tree (B-epsilon tree) on the BPlusTree leaves and node search: every internal
+// node also holds a buffer of pending inserts and erases, kept per child. A change only goes into
+// the root buffer; when a node holds BufferSize messages, the largest group for one child is moved
+// down a level in one go. A leaf is therefore touched once per batch instead of once per insert.
+// find() checks the buffers on the way down, the newest message for the key wins.
+// A larger BufferSize makes inserts cheaper and find() slower, as each level has more to scan.
+// A node that a flush leaves under half full is merged with a sibling when both fit in one node,
+// so leaves emptied by erases are freed. Messages take memory until they reach a leaf, up to
+// BufferSize per internal node, so an erase only frees memory once its tombstone gets there.
+// Limits: in memory the whole tree is already cached by level, so batching only saves the cache
+// misses of the lower levels and the leaf, and every message is copied once per level on its way
+// down. Random inserts gain 2x to 4x over BPlusTree, not the order of magnitude a batch per disk
+// page gives, while find() is 2x to 4x slower.
+template <typename K, typename V, int Order, int BufferSize = 16 * Order>
+class BufferedBPlusTree {
+    static_assert(Order >= 4, "Order must be at least 4");
+    static_assert(BufferSize >= 2, "A buffer must hold at least two messages");
+public:
+    using PtrNode = BPlusNode<K, V, Order>*;
+    using PtrInternal = BufferedBPlusInternal<K, V, Order, BufferSize>*;
+    using PtrLeaf = BPlusLeaf<K, V, Order>*;
+
+    BufferedBPlusTree();
+    BufferedBPlusTree(const BufferedBPlusTree&) = delete;
+    BufferedBPlusTree& operator=(const BufferedBPlusTree&) = delete;
+    ~BufferedBPlusTree();
+
+    void insert(const K& x, V value);   // Overwrites the value of an existing key
+    void erase(const K& x);
+    V* find(const K& x);                // nullptr if x is not in the tree, valid until the next change
+
+    size_t getNodeCount() const;
+    size_t getBytes() const;            // Memory taken by the nodes and their buffers, walks the internal nodes
+
+private:
+    using Tree = BPlusTree<K, V, Order>;
+    using Message = typename BufferedBPlusInternal<K, V, Order, BufferSize>::Message;
+
+    PtrNode root;
+    size_t leaves = 0;
+    size_t internals = 0;
+
+    void put(Message&& message);
+    void flush(PtrInternal cur);        // Move messages down until cur has room, stops early if cur gets over full
+    void flushChild(PtrInternal cur, int pos);
+    void applyToLeaf(PtrLeaf leaf, Message& message);
+    void splitChild(PtrInternal cur, int pos);
+    void fixChild(PtrInternal cur, int pos);        // Merge child[pos] with a sibling if they fit in one node
+    void mergeChildren(PtrInternal cur, int pos);   // child[pos + 1] goes into child[pos]
+    void growRoot();
+    void shrinkRoot();                  // The root is left with a single child
+    size_t subtreeBytes(PtrNode cur) const;
+    void deleteSubtree(PtrNode cur);
+    PtrLeaf newLeaf();
+    PtrInternal newInternal();
+    void freeNode(PtrNode cur);
+
+    static bool underfull(PtrNode cur) { return cur->n < (cur->leaf ? (Order + 1) / 2 : Order / 2 - 1); }
+    static PtrInternal asInternal(PtrNode cur) { return static_cast<PtrInternal>(cur); }
+    static PtrLeaf asLeaf(PtrNode cur) { return static_cast<PtrLeaf>(cur); }
+};
+
+// Implementation below
+
+template <typename K, typename V, int Order, int BufferSize>
+BufferedBPlusTree<K, V, Order, BufferSize>::BufferedBPlusTree() {
+    root = newLeaf();
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+BufferedBPlusTree<K, V, Order, BufferSize>::~BufferedBPlusTree() {
+    deleteSubtree(root);
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::deleteSubtree(PtrNode cur) {
+    if (!cur->leaf) {
+        for (int i = 1; i <= cur->n + 1; i++) {
+            deleteSubtree(asInternal(cur)->child[i]);
+        }
+    }
+    freeNode(cur);
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+typename BufferedBPlusTree<K, V, Order, BufferSize>::PtrLeaf BufferedBPlusTree<K, V, Order, BufferSize>::newLeaf() {
+    PtrLeaf leaf = new BPlusLeaf<K, V, Order>;
+    leaf->leaf = true;
+    leaf->n = 0;
+    leaves++;
+    return leaf;
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+typename BufferedBPlusTree<K, V, Order, BufferSize>::PtrInternal BufferedBPlusTree<K, V, Order, BufferSize>::newInternal() {
+    PtrInternal internal = new BufferedBPlusInternal<K, V, Order, BufferSize>;
+    internal->leaf = false;
+    internal->n = 0;
+    internals++;
+    return internal;
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::freeNode(PtrNode cur) {
+    if (cur->leaf) {
+        delete asLeaf(cur);
+        leaves--;
+    } else {
+        delete asInternal(cur);
+        internals--;
+    }
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+size_t BufferedBPlusTree<K, V, Order, BufferSize>::getNodeCount() const {
+    return leaves + internals;
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+size_t BufferedBPlusTree<K, V, Order, BufferSize>::getBytes() const {
+    return leaves * sizeof(BPlusLeaf<K, V, Order>) + subtreeBytes(root);
+}
+
+// Internal nodes and their buffers below cur
+template <typename K, typename V, int Order, int BufferSize>
+size_t BufferedBPlusTree<K, V, Order, BufferSize>::subtreeBytes(PtrNode cur) const {
+    if (cur->leaf) {
+        return 0;
+    }
+    PtrInternal internal = asInternal(cur);
+    size_t bytes = sizeof(*internal);
+    for (int i = 1; i <= cur->n + 1; i++) {
+        bytes += internal->pending[i].capacity() * sizeof(Message) + subtreeBytes(internal->child[i]);
+    }
+    return bytes;
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::insert(const K& x, V value) {
+    put(Message{x, std::move(value), false});
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::erase(const K& x) {
+    put(Message{x, V(), true});
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+V* BufferedBPlusTree<K, V, Order, BufferSize>::find(const K& x) {
+    PtrNode cur = root;
+    while (!cur->leaf) {
+        int pos = Tree::upperBound(cur, x);
+        std::vector<Message>& pending = asInternal(cur)->pending[pos];
+        for (auto message = pending.rbegin(); message != pending.rend(); ++message) {
+            if (message->key == x) {
+                return message->erase ? nullptr : &message->value;
+            }
+        }
+        cur = asInternal(cur)->child[pos];
+    }
+    int pos = Tree::upperBound(cur, x);
+    if (pos > 1 && cur->key[pos - 1] == x) {
+        return &asLeaf(cur)->value[pos - 1];
+    }
+    return nullptr;
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::put(Message&& message) {
+    if (root->leaf) {
+        // No buffers until the tree has a second level
+        applyToLeaf(asLeaf(root), message);
+        if (root->n == Order + 1) {
+            growRoot();
+        }
+        return;
+    }
+    PtrInternal internal = asInternal(root);
+    internal->pending[Tree::upperBound(root, message.key)].push_back(std::move(message));
+    if (++internal->buffered >= BufferSize) {
+        flush(internal);
+        if (root->n == Order) {
+            growRoot();
+        } else if (root->n == 0) {
+            shrinkRoot();
+        }
+    }
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::flush(PtrInternal cur) {
+    while (cur->buffered >= BufferSize && cur->n < Order) {
+        int best = 1;
+        for (int i = 2; i <= cur->n + 1; i++) {
+            if (cur->pending[i].size() > cur->pending[best].size()) {
+                best = i;
+            }
+        }
+        flushChild(cur, best);
+    }
+}
+
+// Move all messages for child[pos] down a level
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::flushChild(PtrInternal cur, int pos) {
+    std::vector<Message> messages;
+    messages.swap(cur->pending[pos]);
+    cur->buffered -= messages.size();
+
+    PtrNode child = cur->child[pos];
+    if (!child->leaf) {
+        PtrInternal internal = asInternal(child);
+        for (Message& message : messages) {
+            internal->pending[Tree::upperBound(child, message.key)].push_back(std::move(message));
+        }
+        internal->buffered += messages.size();
+        if (internal->buffered >= BufferSize) {
+            flush(internal);
+            if (child->n == Order) {
+                splitChild(cur, pos);
+            } else if (underfull(child)) {
+                fixChild(cur, pos);
+            }
+        }
+        return;
+    }
+
+    // A leaf that splits sends the rest to the right place. If cur fills up,
+    // the rest goes back into the buffer until cur itself has been split.
+    // A leaf left under half full by an erase is merged with a sibling if they fit
+    size_t i = 0;
+    for (; i < messages.size() && cur->n < Order; i++) {
+        int target = Tree::upperBound(cur, messages[i].key);
+        PtrLeaf leaf = asLeaf(cur->child[target]);
+        applyToLeaf(leaf, messages[i]);
+        if (leaf->n == Order + 1) {
+            splitChild(cur, target);
+        } else if (messages[i].erase && underfull(leaf)) {
+            fixChild(cur, target);
+        }
+    }
+    for (; i < messages.size(); i++) {
+        cur->pending[Tree::upperBound(cur, messages[i].key)].push_back(std::move(messages[i]));
+        cur->buffered++;
+    }
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::applyToLeaf(PtrLeaf leaf, Message& message) {
+    int pos = Tree::upperBound(leaf, message.key);
+    bool present = pos > 1 && leaf->key[pos - 1] == message.key;
+    if (message.erase) {
+        if (present) {
+            for (int i = pos; i <= leaf->n; i++) {
+                leaf->key[i - 1] = leaf->key[i];
+                leaf->value[i - 1] = std::move(leaf->value[i]);
+            }
+            leaf->n--;
+        }
+        return;
+    }
+    if (present) {
+        leaf->value[pos - 1] = std::move(message.value);
+        return;
+    }
+    for (int i = leaf->n; i >= pos; i--) {
+        leaf->key[i + 1] = leaf->key[i];
+        leaf->value[i + 1] = std::move(leaf->value[i]);
+    }
+    leaf->key[pos] = message.key;
+    leaf->value[pos] = std::move(message.value);
+    leaf->n++;
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::growRoot() {
+    PtrInternal new_root = newInternal();
+    new_root->child[1] = root;
+    splitChild(new_root, 1);
+    root = new_root;
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::shrinkRoot() {
+    PtrInternal old_root = asInternal(root);
+    std::vector<Message> messages;
+    messages.swap(old_root->pending[1]);
+    root = old_root->child[1];
+    freeNode(old_root);
+    // The messages are newer than anything below, so they go in after it
+    for (Message& message : messages) {
+        put(std::move(message));
+    }
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::splitChild(PtrInternal cur, int pos) {
+    int mid = (Order + 1) / 2;
+    // Same partition as BPlusTree for a leaf of Order + 1 keys or an internal node of Order keys,
+    // the buffers of an internal node go with its childs
+
+    PtrNode node_to_split = cur->child[pos];
+    PtrNode new_node;
+
+    if (node_to_split->leaf) {
+        PtrLeaf old_leaf = asLeaf(node_to_split);
+        PtrLeaf new_leaf = newLeaf();
+        for (int i = mid + 1; i <= Order + 1; i++) {
+            new_leaf->key[i - mid] = old_leaf->key[i];
+            new_leaf->value[i - mid] = std::move(old_leaf->value[i]);
+        }
+        new_leaf->n = Order + 1 - mid;
+        old_leaf->n = mid;
+        new_leaf->next = old_leaf->next;
+        old_leaf->next = new_leaf;
+        new_node = new_leaf;
+    } else {
+        PtrInternal old_internal = asInternal(node_to_split);
+        PtrInternal new_internal = newInternal();
+        for (int i = mid + 1; i <= Order; i++) {
+            new_internal->key[i - mid] = old_internal->key[i];
+        }
+        for (int i = mid + 1; i <= Order + 1; i++) {
+            new_internal->child[i - mid] = old_internal->child[i];
+            new_internal->pending[i - mid].swap(old_internal->pending[i]);
+            new_internal->buffered += new_internal->pending[i - mid].size();
+        }
+        new_internal->n = Order - mid;
+        old_internal->n = mid - 1;
+        old_internal->buffered -= new_internal->buffered;
+        new_node = new_internal;
+    }
+
+    for (int i = cur->n; i >= pos; i--) {
+        cur->key[i + 1] = cur->key[i];
+    }
+    for (int i = cur->n + 1; i > pos; i--) {
+        cur->child[i + 1] = cur->child[i];
+        cur->pending[i + 1].swap(cur->pending[i]);
+    }
+    cur->n++;
+    cur->key[pos] = node_to_split->leaf ? new_node->key[1] : node_to_split->key[mid];
+    cur->child[pos + 1] = new_node;
+
+    // Messages for the new node move to their own buffer, in the same order
+    std::vector<Message>& left = cur->pending[pos];
+    auto right = std::stable_partition(left.begin(), left.end(), [&](const Message& m) { return cur->key[pos] > m.key; });
+    cur->pending[pos + 1].assign(std::make_move_iterator(right), std::make_move_iterator(left.end()));
+    left.erase(right, left.end());
+}
+
+// Unlike BPlusTree::fixChild there is no borrowing: a node moved between siblings would have to
+// take its share of cur's buffers along. A sibling too full to merge with is at least half full.
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::fixChild(PtrInternal cur, int pos) {
+    PtrNode node = cur->child[pos];
+    // Most keys a node keeps between changes, an internal merge also takes the separator
+    int room = node->leaf ? Order : Order - 2;
+    if (pos > 1 && cur->child[pos - 1]->n + node->n <= room) {
+        mergeChildren(cur, pos - 1);
+    } else if (pos <= cur->n && node->n + cur->child[pos + 1]->n <= room) {
+        mergeChildren(cur, pos);
+    }
+}
+
+template <typename K, typename V, int Order, int BufferSize>
+void BufferedBPlusTree<K, V, Order, BufferSize>::mergeChildren(PtrInternal cur, int pos) {
+    PtrNode left = cur->child[pos];
+    PtrNode right = cur->child[pos + 1];
+    if (left->leaf) {
+        PtrLeaf left_leaf = asLeaf(left);
+        PtrLeaf right_leaf = asLeaf(right);
+        for (int i = 1; i <= right->n; i++) {
+            left->key[left->n + i] = right->key[i];
+            left_leaf->value[left->n + i] = std::move(right_leaf->value[i]);
+        }
+        left->n += right->n;
+        left_leaf->next = right_leaf->next;
+    } else {
+        PtrInternal left_internal = asInternal(left);
+        PtrInternal right_internal = asInternal(right);
+        left->key[left->n + 1] = cur->key[pos];
+        for (int i = 1; i <= right->n; i++) {
+            left->key[left->n + 1 + i] = right->key[i];
+        }
+        for (int i = 1; i <= right->n + 1; i++) {
+            left_internal->child[left->n + 1 + i] = right_internal->child[i];
+            left_internal->pending[left->n + 1 + i].swap(right_internal->pending[i]);
+        }
+        left->n += right->n + 1;
+        left_internal->buffered += right_internal->buffered;
+    }
+    freeNode(right);
+
+    // The two buffers hold disjoint keys, so one after the other keeps the order for each key
+    std::vector<Message>& merged = cur->pending[pos];
+    merged.insert(merged.end(), std::make_move_iterator(cur->pending[pos + 1].begin()),
+        std::make_move_iterator(cur->pending[pos + 1].end()));
+    cur->pending[pos + 1].clear();
+    for (int i = pos + 1; i <= cur->n; i++) {
+        cur->key[i - 1] = cur->key[i];
+        cur->child[i] = cur->child[i + 1];
+        cur->pending[i].swap(cur->pending[i + 1]);
+    }
+    cur->n--;
+}
+
+#endif // BUFFERED_BPLUS_TREE_HPP
@@ -0,0 +1,274 @@
+#if !defined(COMPACT_FIBO_HEAP_HPP)
+#define COMPACT_FIBO_HEAP_HPP
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+// Fibonacci heap whose nodes live in one growable array and link to each other by 32-bit index.
+// Popped slots are recycled through a free list, so a handle is only valid until its key is popped.
+template <typename T>
+class CompactFibonacciHeap {
+public:
+	using Handle = uint32_t;
+	static constexpr Handle NIL = UINT32_MAX;
+
+	bool empty() const;
+	int getSize() const;
+	Handle push(const T &key);
+	Handle push(T &&key);
+	Handle decrease(Handle node, const T &key);
+	const T& top() const;
+	T pop();
+	void reserve(int capacity);
+	void clear();
+	CompactFibonacciHeap (const int capacity = 0);
+
+private:
+	struct Node {
+		template <typename... Args>
+		explicit Node (Args&&... args) : key(std::forward<Args>(args)...) {}
+		T key;
+		Handle parent = NIL;
+		Handle next_sibling = NIL;	// Also links the free list
+		Handle prev_sibling = NIL;
+		Handle first_child = NIL;
+		uint16_t rank = 0;
+		bool marked = false;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<Handle> degree_table;	// Scratch for rearrange(), indexed by rank
+	Handle head = NIL;
+	Handle min_node = NIL;
+	Handle free_list = NIL;
+	int size = 0;
+
+	template <typename U>
+	Handle allocate(U&& key);
+	template <typename U>
+	Handle insertKey(U&& key);
+	Handle link(Handle node_a, Handle node_b);	// The root with the larger key becomes a child
+	void rearrange();
+	void removeRoot(Handle node);
+	void insertTree(Handle node);
+};
+
+// Implementation below
+
+template <typename T>
+CompactFibonacciHeap<T>::CompactFibonacciHeap (const int capacity) {
+	reserve(capacity);
+}
+
+template <typename T>
+void CompactFibonacciHeap<T>::reserve(int capacity) {
+	nodes.reserve(capacity);
+}
+
+template <typename T>
+void CompactFibonacciHeap<T>::clear() {
+	nodes.clear();
+	head = min_node = free_list = NIL;
+	size = 0;
+}
+
+template <typename T>
+bool CompactFibonacciHeap<T>::empty() const {
+	return head == NIL;
+}
+
+template <typename T>
+int CompactFibonacciHeap<T>::getSize() const {
+	return size;
+}
+
+template <typename T>
+template <typename U>
+typename CompactFibonacciHeap<T>::Handle CompactFibonacciHeap<T>::allocate(U&& key) {
+	Handle id;
+	if (free_list != NIL) {
+		id = free_list;
+		free_list = nodes[id].next_sibling;
+		nodes[id].key = std::forward<U>(key);
+	} else {
+		id = nodes.size();
+		nodes.emplace_back(std::forward<U>(key));
+	}
+	Node& node = nodes[id];
+	node.parent = node.next_sibling = node.prev_sibling = node.first_child = NIL;
+	node.rank = 0;
+	node.marked = false;
+	return id;
+}
+
+template <typename T>
+typename CompactFibonacciHeap<T>::Handle CompactFibonacciHeap<T>::push(const T& key) {
+	return insertKey(key);
+}
+
+template <typename T>
+typename CompactFibonacciHeap<T>::Handle CompactFibonacciHeap<T>::push(T&& key) {
+	return insertKey(std::move(key));
+}
+
+template <typename T>
+template <typename U>
+typename CompactFibonacciHeap<T>::Handle CompactFibonacciHeap<T>::insertKey(U&& key) {
+	size++;
+	Handle new_tree = allocate(std::forward<U>(key));
+	insertTree(new_tree);
+	if (min_node == NIL || nodes[new_tree].key < nodes[min_node].key) {
+		min_node = new_tree;
+	}
+	return new_tree;
+}
+
+template <typename T>
+void CompactFibonacciHeap<T>::insertTree(Handle id) {
+	Node& node = nodes[id];
+	node.next_sibling = head;
+	node.prev_sibling = NIL;
+	if (head != NIL) {
+		nodes[head].prev_sibling = id;
+	}
+	head = id;
+}
+
+template <typename T>
+typename CompactFibonacciHeap<T>::Handle CompactFibonacciHeap<T>::decrease(Handle id, const T& key) {
+	nodes[id].key = key;
+	// A key smaller than the minimum is always cut below, so it ends up as a root
+	if (key < nodes[min_node].key) {
+		min_node = id;
+	}
+	// If this is a root or the change does not violate the heap order, do nothing
+	if (nodes[id].parent == NIL || nodes[nodes[id].parent].key < key) {
+		return id;
+	}
+
+	// Cascading cut (including the original cut)
+	Handle cur = id;
+	do {
+		Node& node = nodes[cur];
+		Handle parent = node.parent;
+		if (node.prev_sibling != NIL) {
+			nodes[node.prev_sibling].next_sibling = node.next_sibling;
+		} else {
+			nodes[parent].first_child = node.next_sibling;
+		}
+		if (node.next_sibling != NIL) {
+			nodes[node.next_sibling].prev_sibling = node.prev_sibling;
+		}
+		node.parent = NIL;
+		node.marked = false;	// Root should be unmarked
+		insertTree(cur);
+
+		nodes[parent].rank--;
+		cur = parent;
+	} while (nodes[cur].parent != NIL && nodes[cur].marked);
+
+	// If the cascading cut ends at a non-root node
+	if (nodes[cur].parent != NIL) {
+		nodes[cur].marked = true;
+	}
+	return id;
+}
+
+template <typename T>
+const T& CompactFibonacciHeap<T>::top() const {
+	// Did not check underflow!
+	return nodes[min_node].key;
+}
+
+template <typename T>
+T CompactFibonacciHeap<T>::pop() {
+	// Did not check underflow!
+	T min_key = std::move(nodes[min_node].key);	// The slot goes to the free list, leave nothing behind in it
+	removeRoot(min_node);
+	size--;
+	rearrange();	// Also finds the new minimum
+	return min_key;
+}
+
+template <typename T>
+typename CompactFibonacciHeap<T>::Handle CompactFibonacciHeap<T>::link(Handle node_a, Handle node_b) {
+	if (nodes[node_b].key < nodes[node_a].key) {
+		Handle tmp = node_a;
+		node_a = node_b;
+		node_b = tmp;
+	}
+	Node& a = nodes[node_a];
+	Node& b = nodes[node_b];
+	// Insert b into the head of a's children list
+	b.next_sibling = a.first_child;
+	if (a.first_child != NIL) {
+		nodes[a.first_child].prev_sibling = node_b;
+	}
+	b.prev_sibling = NIL;
+	b.parent = node_a;
+	a.first_child = node_b;
+	a.rank++;
+	return node_a;
+}
+
+template <typename T>
+void CompactFibonacciHeap<T>::rearrange() {
+	// Link trees of the same rank until all ranks are distinct
+	for (Handle itr = head, nxt; itr != NIL; itr = nxt) {
+		nxt = nodes[itr].next_sibling;
+		Handle carry = itr;
+		while (true) {
+			uint16_t rank = nodes[carry].rank;
+			if (degree_table.size() <= rank) {
+				degree_table.resize(rank + 1, NIL);
+			}
+			if (degree_table[rank] == NIL) {
+				degree_table[rank] = carry;
+				break;
+			}
+			carry = link(carry, degree_table[rank]);
+			degree_table[rank] = NIL;
+		}
+	}
+
+	// Collect the roots back into the list
+	head = min_node = NIL;
+	for (Handle& root : degree_table) {
+		if (root == NIL) {
+			continue;
+		}
+		insertTree(root);
+		if (min_node == NIL || nodes[root].key < nodes[min_node].key) {
+			min_node = root;
+		}
+		root = NIL;
+	}
+}
+
+template <typename T>
+void CompactFibonacciHeap<T>::removeRoot(Handle id) {
+	Node& node = nodes[id];
+	// cut the tree from the heap
+	if (node.prev_sibling != NIL) {
+		nodes[node.prev_sibling].next_sibling = node.next_sibling;
+	} else {
+		head = node.next_sibling;
+	}
+	if (node.next_sibling != NIL) {
+		nodes[node.next_sibling].prev_sibling = node.prev_sibling;
+	}
+
+	// Make every subtree of the node a tree
+	for (Handle itr = node.first_child, nxt; itr != NIL; itr = nxt) {
+		nxt = nodes[itr].next_sibling;
+		nodes[itr].parent = NIL;
+		nodes[itr].marked = false;
+		insertTree(itr);
+	}
+
+	node.next_sibling = free_list;
+	free_list = id;
+}
+
+#endif // COMPACT_FIBO_HEAP_HPP
@@ -0,0 +1,343 @@
+#if !defined(CONCURRENT_BPLUS_TREE_HPP)
+#define CONCURRENT_BPLUS_TREE_HPP
+
+#include "BPlusTree.hpp"
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <cstdint>
+
+template <typename K, typename V, int Order>
+class ConcurrentBPlusTree;
+
+// Every node carries a version lock: bit 1 is set while a writer holds the node, and
+// unlocking bumps the version. Readers never write to a node, they remember the version
+// they saw and check it again after reading, and start over if it moved.
+template <typename K, typename V, int Order>
+class ConcurrentBPlusNode {
+public:
+    friend class ConcurrentBPlusTree<K, V, Order>;
+protected:
+    std::atomic<uint64_t> version{0};
+    bool leaf;
+    int n;          // Number of keys in the node
+    K key[Order + 2];
+};
+
+template <typename K, typename V, int Order>
+class ConcurrentBPlusInternal : public ConcurrentBPlusNode<K, V, Order> {
+public:
+    friend class ConcurrentBPlusTree<K, V, Order>;
+protected:
+    ConcurrentBPlusNode<K, V, Order>* child[Order + 2];
+    // child[i] < key[i] <= child[i + 1] < key[i + 1]
+};
+
+template <typename K, typename V, int Order>
+class ConcurrentBPlusLeaf : public ConcurrentBPlusNode<K, V, Order> {
+public:
+    friend class ConcurrentBPlusTree<K, V, Order>;
+protected:
+    V value[Order + 2];
+    ConcurrentBPlusLeaf* next = nullptr;
+};
+
+// BPlusTree for many threads at once, with optimistic lock coupling.
+// find() takes no locks. insert() reads its way down like find() and write-locks only the
+// leaf it changes, or the node it splits together with that node's parent.
+// Full nodes are split on the way down, so a split never has to go back up the tree.
+// Nodes are never freed while the tree is alive, a reader may still be looking at any of them.
+// Readers can see keys and values half written before they notice the version change, so both
+// must be trivially copyable.
+template <typename K, typename V, int Order>
+class ConcurrentBPlusTree {
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "Optimistic readers copy keys and values that may be changing under them");
+    // A full internal node (Order - 1 keys) is split in two, each half needs a key of its own
+    static_assert(Order >= 4, "Order must be at least 4");
+public:
+    using PtrNode = ConcurrentBPlusNode<K, V, Order>*;
+    using PtrInternal = ConcurrentBPlusInternal<K, V, Order>*;
+    using PtrLeaf = ConcurrentBPlusLeaf<K, V, Order>*;
+
+    ConcurrentBPlusTree();
+    ConcurrentBPlusTree(const ConcurrentBPlusTree&) = delete;
+    ConcurrentBPlusTree& operator=(const ConcurrentBPlusTree&) = delete;
+    ~ConcurrentBPlusTree();     // Not thread safe
+
+    void insert(const K& x, const V& value);    // Overwrites the value of an existing key
+    bool find(const K& x, V& value);
+
+private:
+    std::atomic<PtrNode> root;
+
+    bool tryInsert(const K& x, const V& value);     // false if it has to start over
+    void splitChild(PtrInternal cur, int pos);      // cur and its child must be write locked
+    void splitRoot(PtrNode old_root);               // old_root must be write locked
+    void deleteSubtree(PtrNode cur);
+
+    static int upperBound(PtrNode cur, const K& x);
+    static bool isFull(PtrNode cur);
+    static uint64_t readLock(PtrNode cur);
+    static bool validate(PtrNode cur, uint64_t version);
+    static bool upgradeLock(PtrNode cur, uint64_t version);
+    static void writeUnlock(PtrNode cur);
+    static PtrInternal asInternal(PtrNode cur) { return static_cast<PtrInternal>(cur); }
+    static PtrLeaf asLeaf(PtrNode cur) { return static_cast<PtrLeaf>(cur); }
+};
+
+// Implementation below
+
+template <typename K, typename V, int Order>
+ConcurrentBPlusTree<K, V, Order>::ConcurrentBPlusTree() {
+    PtrLeaf leaf = new ConcurrentBPlusLeaf<K, V, Order>;
+    leaf->leaf = true;
+    leaf->n = 0;
+    root.store(leaf);
+}
+
+template <typename K, typename V, int Order>
+ConcurrentBPlusTree<K, V, Order>::~ConcurrentBPlusTree() {
+    deleteSubtree(root.load());
+}
+
+template <typename K, typename V, int Order>
+void ConcurrentBPlusTree<K, V, Order>::deleteSubtree(PtrNode cur) {
+    if (cur->leaf) {
+        delete asLeaf(cur);
+        return;
+    }
+    for (int i = 1; i <= cur->n + 1; i++) {
+        deleteSubtree(asInternal(cur)->child[i]);
+    }
+    delete asInternal(cur);
+}
+
+// Wait until no writer holds cur and return the version seen
+template <typename K, typename V, int Order>
+uint64_t ConcurrentBPlusTree<K, V, Order>::readLock(PtrNode cur) {
+    uint64_t version = cur->version.load(std::memory_order_acquire);
+    while (version & 2) {
+        std::this_thread::yield();
+        version = cur->version.load(std::memory_order_acquire);
+    }
+    return version;
+}
+
+// Whether everything read from cur since readLock returned version is consistent
+template <typename K, typename V, int Order>
+bool ConcurrentBPlusTree<K, V, Order>::validate(PtrNode cur, uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return cur->version.load(std::memory_order_relaxed) == version;
+}
+
+template <typename K, typename V, int Order>
+bool ConcurrentBPlusTree<K, V, Order>::upgradeLock(PtrNode cur, uint64_t version) {
+    if (!cur->version.compare_exchange_strong(version, version + 2, std::memory_order_acquire)) {
+        return false;
+    }
+    // Readers must see the lock bit before any of the changes that follow
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+}
+
+template <typename K, typename V, int Order>
+void ConcurrentBPlusTree<K, V, Order>::writeUnlock(PtrNode cur) {
+    cur->version.fetch_add(2, std::memory_order_release);
+}
+
+// Like BPlusTree::upperBound, but n may be garbage when a writer is busy with the node
+template <typename K, typename V, int Order>
+int ConcurrentBPlusTree<K, V, Order>::upperBound(PtrNode cur, const K& x) {
+    int n = cur->n;
+    n = n < 0 ? 0 : n > Order ? Order : n;
+    return BPlusSearch<K>::upperBound(cur->key + 1, n, x) + 1;
+}
+
+// A full node has no room for the key a split below it or an insert into it would add
+template <typename K, typename V, int Order>
+bool ConcurrentBPlusTree<K, V, Order>::isFull(PtrNode cur) {
+    return cur->leaf ? cur->n >= Order : cur->n >= Order - 1;
+}
+
+template <typename K, typename V, int Order>
+bool ConcurrentBPlusTree<K, V, Order>::find(const K& x, V& value) {
+    while (true) {
+        PtrNode cur = root.load(std::memory_order_acquire);
+        uint64_t version = readLock(cur);
+        if (cur != root.load(std::memory_order_acquire)) {
+            continue;   // The root was split before we got to it
+        }
+        bool restart = false;
+        while (!cur->leaf) {
+            PtrNode next = asInternal(cur)->child[upperBound(cur, x)];
+            if (!validate(cur, version)) {
+                restart = true;
+                break;
+            }
+            uint64_t next_version = readLock(next);
+            if (!validate(cur, version)) {
+                restart = true;
+                break;
+            }
+            cur = next;
+            version = next_version;
+        }
+        if (restart) {
+            continue;
+        }
+        int pos = upperBound(cur, x);
+        bool found = pos > 1 && cur->key[pos - 1] == x;
+        V copy;
+        if (found) {
+            copy = asLeaf(cur)->value[pos - 1];
+        }
+        if (!validate(cur, version)) {
+            continue;
+        }
+        if (found) {
+            value = copy;
+        }
+        return found;
+    }
+}
+
+template <typename K, typename V, int Order>
+void ConcurrentBPlusTree<K, V, Order>::insert(const K& x, const V& value) {
+    while (!tryInsert(x, value)) {}
+}
+
+template <typename K, typename V, int Order>
+bool ConcurrentBPlusTree<K, V, Order>::tryInsert(const K& x, const V& value) {
+    PtrNode cur = root.load(std::memory_order_acquire);
+    uint64_t version = readLock(cur);
+    if (cur != root.load(std::memory_order_acquire)) {
+        return false;
+    }
+    PtrNode parent = nullptr;
+    uint64_t parent_version = 0;
+    int pos_in_parent = 0;
+
+    while (true) {
+        if (isFull(cur)) {
+            // Split it now so the insert below never has to come back up here
+            if (parent != nullptr && !upgradeLock(parent, parent_version)) {
+                return false;
+            }
+            if (!upgradeLock(cur, version)) {
+                if (parent != nullptr) {
+                    writeUnlock(parent);
+                }
+                return false;
+            }
+            if (parent != nullptr) {
+                splitChild(asInternal(parent), pos_in_parent);
+                writeUnlock(parent);
+            } else if (cur == root.load(std::memory_order_acquire)) {
+                splitRoot(cur);
+            }
+            writeUnlock(cur);
+            return false;
+        }
+        if (cur->leaf) {
+            break;
+        }
+        int pos = upperBound(cur, x);
+        PtrNode next = asInternal(cur)->child[pos];
+        if (!validate(cur, version)) {
+            return false;
+        }
+        uint64_t next_version = readLock(next);
+        if (!validate(cur, version)) {
+            return false;
+        }
+        parent = cur;
+        parent_version = version;
+        pos_in_parent = pos;
+        cur = next;
+        version = next_version;
+    }
+
+    if (!upgradeLock(cur, version)) {
+        return false;
+    }
+    if (parent != nullptr && !validate(parent, parent_version)) {
+        writeUnlock(cur);
+        return false;
+    }
+    PtrLeaf leaf = asLeaf(cur);
+    int pos = upperBound(leaf, x);
+    if (pos > 1 && leaf->key[pos - 1] == x) {
+        leaf->value[pos - 1] = value;
+    } else {
+        for (int i = leaf->n; i >= pos; i--) {
+            leaf->key[i + 1] = leaf->key[i];
+            leaf->value[i + 1] = leaf->value[i];
+        }
+        leaf->key[pos] = x;
+        leaf->value[pos] = value;
+        leaf->n++;
+    }
+    writeUnlock(cur);
+    return true;
+}
+
+template <typename K, typename V, int Order>
+void ConcurrentBPlusTree<K, V, Order>::splitRoot(PtrNode old_root) {
+    PtrInternal new_root = new ConcurrentBPlusInternal<K, V, Order>;
+    new_root->leaf = false;
+    new_root->n = 0;
+    new_root->child[1] = old_root;
+    splitChild(new_root, 1);
+    root.store(new_root, std::memory_order_release);
+}
+
+template <typename K, typename V, int Order>
+void ConcurrentBPlusTree<K, V, Order>::splitChild(PtrInternal cur, int pos) {
+    // Same partition as BPlusTree::splitChild, but on a node that is full rather than over full:
+    //          a leaf of n keys keeps [1, mid], the new one gets [mid + 1, n]
+    //          an internal node keeps keys [1, mid - 1] and gives key mid to the parent
+    PtrNode node_to_split = cur->child[pos];
+    int n = node_to_split->n;
+    int mid = (n + 1) / 2;
+    PtrNode new_node;
+
+    if (node_to_split->leaf) {
+        PtrLeaf old_leaf = asLeaf(node_to_split);
+        PtrLeaf new_leaf = new ConcurrentBPlusLeaf<K, V, Order>;
+        for (int i = mid + 1; i <= n; i++) {
+            new_leaf->key[i - mid] = old_leaf->key[i];
+            new_leaf->value[i - mid] = old_leaf->value[i];
+        }
+        new_leaf->n = n - mid;
+        old_leaf->n = mid;
+        new_leaf->next = old_leaf->next;
+        old_leaf->next = new_leaf;
+        new_node = new_leaf;
+    } else {
+        PtrInternal old_internal = asInternal(node_to_split);
+        PtrInternal new_internal = new ConcurrentBPlusInternal<K, V, Order>;
+        for (int i = mid + 1; i <= n; i++) {
+            new_internal->key[i - mid] = old_internal->key[i];
+        }
+        for (int i = mid + 1; i <= n + 1; i++) {
+            new_internal->child[i - mid] = old_internal->child[i];
+        }
+        new_internal->n = n - mid;
+        old_internal->n = mid - 1;
+        new_node = new_internal;
+    }
+    new_node->leaf = node_to_split->leaf;
+
+    for (int i = cur->n; i >= pos; i--) {
+        cur->key[i + 1] = cur->key[i];
+    }
+    for (int i = cur->n + 1; i > pos; i--) {
+        cur->child[i + 1] = cur->child[i];
+    }
+    cur->n++;
+    cur->key[pos] = node_to_split->leaf ? new_node->key[1] : node_to_split->key[mid];
+    cur->child[pos + 1] = new_node;
+}
+
+#endif // CONCURRENT_BPLUS_TREE_HPP
@@ -0,0 +1,184 @@
+#if !defined(DARY_HEAP_HPP)
+#define DARY_HEAP_HPP
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+// Implicit D-ary heap stored in one array, with the same handle based interface as PairHeap and FibonacciHeap.
+// position[] maps a handle to the slot of its key, so decrease() can find it.
+// A handle is only valid until its key is popped, after which it may be reused.
+template <typename T, int D = 4>
+class DaryHeap {
+	static_assert(D >= 2, "A heap needs at least two children per node");
+public:
+	using Handle = uint32_t;
+
+	bool empty() const;
+	int getSize() const;
+	Handle push(const T &key);
+	Handle push(T &&key);
+	template <typename... Args>
+	Handle emplace(Args&&... args);
+	Handle decrease(Handle handle, const T &key);
+	const T& top() const;
+	T pop();	// The key is moved out of the heap
+	void reserve(int capacity);
+	void clear();
+	DaryHeap (const int capacity = 0);
+
+private:
+	struct Entry {
+		T key;
+		Handle handle;
+	};
+
+	std::vector<Entry> heap;
+	std::vector<uint32_t> position;	// Indexed by handle
+	std::vector<Handle> free_handles;
+
+	template <typename U>
+	Handle insertKey(U&& key);
+	void siftUp(uint32_t pos);
+	void siftDown(uint32_t pos);
+};
+
+// Implementation below
+
+template <typename T, int D>
+DaryHeap<T, D>::DaryHeap (const int capacity) {
+	reserve(capacity);
+}
+
+template <typename T, int D>
+void DaryHeap<T, D>::reserve(int capacity) {
+	heap.reserve(capacity);
+	position.reserve(capacity);
+}
+
+template <typename T, int D>
+void DaryHeap<T, D>::clear() {
+	heap.clear();
+	position.clear();
+	free_handles.clear();
+}
+
+template <typename T, int D>
+bool DaryHeap<T, D>::empty() const {
+	return heap.empty();
+}
+
+template <typename T, int D>
+int DaryHeap<T, D>::getSize() const {
+	return heap.size();
+}
+
+template <typename T, int D>
+typename DaryHeap<T, D>::Handle DaryHeap<T, D>::push(const T& key) {
+	return insertKey(key);
+}
+
+template <typename T, int D>
+typename DaryHeap<T, D>::Handle DaryHeap<T, D>::push(T&& key) {
+	return insertKey(std::move(key));
+}
+
+template <typename T, int D>
+template <typename... Args>
+typename DaryHeap<T, D>::Handle DaryHeap<T, D>::emplace(Args&&... args) {
+	return insertKey(T(std::forward<Args>(args)...));
+}
+
+template <typename T, int D>
+template <typename U>
+typename DaryHeap<T, D>::Handle DaryHeap<T, D>::insertKey(U&& key) {
+	Handle handle;
+	if (!free_handles.empty()) {
+		handle = free_handles.back();
+		free_handles.pop_back();
+	} else {
+		handle = position.size();
+		position.push_back(0);
+	}
+	heap.push_back(Entry{std::forward<U>(key), handle});
+	position[handle] = heap.size() - 1;
+	siftUp(heap.size() - 1);
+	return handle;
+}
+
+template <typename T, int D>
+typename DaryHeap<T, D>::Handle DaryHeap<T, D>::decrease(Handle handle, const T& key) {
+	uint32_t pos = position[handle];
+	heap[pos].key = key;
+	siftUp(pos);
+	return handle;
+}
+
+template <typename T, int D>
+const T& DaryHeap<T, D>::top() const {
+	// Did not check underflow!
+	return heap[0].key;
+}
+
+template <typename T, int D>
+T DaryHeap<T, D>::pop() {
+	// Did not check underflow!
+	T min_key = std::move(heap[0].key);
+	free_handles.push_back(heap[0].handle);
+	if (heap.size() > 1) {
+		heap[0] = std::move(heap.back());
+		position[heap[0].handle] = 0;
+		heap.pop_back();
+		siftDown(0);
+	} else {
+		heap.pop_back();
+	}
+	return min_key;
+}
+
+// Move the entry at pos towards the root, shifting parents down into the hole
+template <typename T, int D>
+void DaryHeap<T, D>::siftUp(uint32_t pos) {
+	Entry entry = std::move(heap[pos]);
+	while (pos > 0) {
+		uint32_t parent = (pos - 1) / D;
+		if (!(entry.key < heap[parent].key)) {
+			break;
+		}
+		heap[pos] = std::move(heap[parent]);
+		position[heap[pos].handle] = pos;
+		pos = parent;
+	}
+	heap[pos] = std::move(entry);
+	position[heap[pos].handle] = pos;
+}
+
+// Move the entry at pos towards the leaves, shifting the smallest child up into the hole
+template <typename T, int D>
+void DaryHeap<T, D>::siftDown(uint32_t pos) {
+	uint32_t size = heap.size();
+	Entry entry = std::move(heap[pos]);
+	while (true) {
+		uint32_t first_child = pos * D + 1;
+		if (first_child >= size) {
+			break;
+		}
+		uint32_t last_child = first_child + D < size ? first_child + D : size;
+		uint32_t min_child = first_child;
+		for (uint32_t child = first_child + 1; child < last_child; child++) {
+			if (heap[child].key < heap[min_child].key) {
+				min_child = child;
+			}
+		}
+		if (!(heap[min_child].key < entry.key)) {
+			break;
+		}
+		heap[pos] = std::move(heap[min_child]);
+		position[heap[pos].handle] = pos;
+		pos = min_child;
+	}
+	heap[pos] = std::move(entry);
+	position[heap[pos].handle] = pos;
+}
+
+#endif // DARY_HEAP_HPP
@@ -1,6 +1,10 @@
 #if !defined(FIBO_HEAP_HPP)
 #define FIBO_HEAP_HPP
 
+#include <vector>
+#include <new>
+#include <utility>
+
 template <typename T>
 class FibonacciHeap; // Forward declaration for friendship
 
@@ -26,36 +30,91 @@ private:
 	int rank = 0;
 
 public:
-	FibonacciNode () = default;
-	FibonacciNode (const T& key);
+	template <typename... Args>
+	explicit FibonacciNode (Args&&... args) : key(std::forward<Args>(args)...) {}
 
 	friend class FibonacciHeap<T>;
 	friend FibonacciNode* merge<T>(FibonacciNode* node_a, FibonacciNode* node_b);
 	friend void merge<T>(FibonacciHeap<T>* fib_a, FibonacciHeap<T>* fib_b);
 };
 
+// A node sized piece of a block: either a node in the heap or the link to the next free slot
+template <typename T>
+union FibonacciSlot {
+	FibonacciNode<T> node;
+	FibonacciSlot* next_free;
+	FibonacciSlot () : next_free(nullptr) {}
+	~FibonacciSlot () {}	// The heap destroys the nodes it holds
+};
+
+// T needs operator< and operator>, and a move constructor for pop(). Keys are constructed in
+// place in the node, so T need not be default constructible; only decrease() assigns to a key.
 template <typename T>
 class FibonacciHeap {
 	using PtrNode = FibonacciNode<T>*;
+	using PtrSlot = FibonacciSlot<T>*;
 	PtrNode head = nullptr;
+	PtrNode tail = nullptr;		// Last root, for splicing in O(1)
+	PtrNode min_node = nullptr;	// Root holding the minimum key
 	int size = 0;
+	std::vector<PtrNode> degree_table;	// Scratch for rearrange(), indexed by rank
+
+	// Incremental consolidation, see setConsolidationBudget()
+	// Roots in [boundary, tail] are filed in degree_table by rank, roots before boundary are pending
+	int link_budget = 0;
+	PtrNode boundary = nullptr;
+
+	// Nodes live in blocks of slots owned by the heap, popped nodes are recycled.
+	// A free slot holds no key, only the pointer to the next free slot.
+	std::vector<PtrSlot> blocks;
+	PtrSlot free_slots = nullptr;
 public:
-	bool empty();
+	bool empty() const;
 	PtrNode push(const T &key);
+	PtrNode push(T &&key);
+	template <typename... Args>
+	PtrNode emplace(Args&&... args);
 	PtrNode decrease(PtrNode node, const T &key);
-	T top();
-	T pop();
+	const T& top() const;
+	T pop();	// The key is moved out of the node
+	void meld(FibonacciHeap&& other);	// Take over all the trees of other
+	void setConsolidationBudget(int max_steps);
+
+	template <typename Iterator>
+	void push_range(Iterator first, Iterator last);
+	template <typename OutputIterator>
+	OutputIterator pop_k(int k, OutputIterator out);	// Pop the k smallest keys in order
+
 	FibonacciHeap (const int capacity = 0);
-	~FibonacciHeap () = default;
+	template <typename Iterator>
+	FibonacciHeap (Iterator first, Iterator last);
+	FibonacciHeap (const FibonacciHeap&) = delete;
+	FibonacciHeap& operator= (const FibonacciHeap&) = delete;
+	~FibonacciHeap ();
 	void clear();
 
+	friend void merge<T>(FibonacciHeap* fib_a, FibonacciHeap* fib_b);
+
 	void printHeap();
 
 private:
 	void rearrange();				// Rearrange the trees
+	void rearrangeBounded();		// Do at most link_budget steps of consolidation
+	void resetConsolidation();		// Forget the partial degree table
+	void unfileRoot(PtrNode node);	// Make a filed root pending again
+	void findMin();
 	void removeRoot(PtrNode node);	// Remove a root of the tree
 	void insertTree(PtrNode node);	// Insert a new tree
-	void deleteTree(PtrNode node);	// For memory recollection
+	void unlinkRoot(PtrNode node);	// Cut a root out of the root list
+	void insertRootBefore(PtrNode pos, PtrNode node);	// nullptr means at the end
+	PtrSlot newBlock(int count);
+	template <typename... Args>
+	PtrNode insertKey(Args&&... args);
+	template <typename... Args>
+	PtrNode allocateNode(Args&&... args);	// Constructs the key in place from args
+	void releaseNode(PtrNode node);		// Destroys the key
+	void addFreeSlot(PtrSlot slot);		// slot holds no node
+	void destroyTrees(PtrNode node);	// Destroy the keys of node, its siblings and their descendants
 	void printTree(PtrNode node, int step);
 };
 
@@ -64,9 +123,10 @@ private:
 #include <iostream>
 #include <cmath>
 #include <cstring>
-
-template <typename T>
-FibonacciNode<T>::FibonacciNode(const T& key) : key(key) {}
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <utility>
 
 // Merge two trees
 template <typename T>
@@ -90,51 +150,181 @@ FibonacciNode<T>* merge(FibonacciNode<T>* node_a, FibonacciNode<T>* node_b) {
 	}
 }
 
+// Meld fib_b into fib_a in O(1) (plus a step per node block of fib_b), fib_b is left empty
+// Handles from both heaps remain valid
+template <typename T>
+void merge(FibonacciHeap<T>* fib_a, FibonacciHeap<T>* fib_b) {
+	if (fib_a == fib_b || fib_b->head == nullptr) {
+		return;
+	}
+	// The nodes of b now belong to a
+	fib_a->blocks.insert(fib_a->blocks.end(), fib_b->blocks.begin(), fib_b->blocks.end());
+	fib_b->blocks.clear();
+	if (fib_a->free_slots == nullptr) {
+		fib_a->free_slots = fib_b->free_slots;
+	}	// Otherwise the free slots of b are simply kept until a is cleared
+	fib_b->free_slots = nullptr;
+
+	fib_b->resetConsolidation();
+	if (fib_a->head == nullptr) {
+		fib_a->tail = fib_b->tail;
+		fib_a->min_node = fib_b->min_node;
+	} else {
+		// Splice the root list of b in front of a's
+		fib_b->tail->next_sibling = fib_a->head;
+		fib_a->head->prev_sibling = fib_b->tail;
+		if (fib_b->min_node->key < fib_a->min_node->key) {
+			fib_a->min_node = fib_b->min_node;
+		}
+	}
+	fib_a->head = fib_b->head;	// Trees of b are pending in a
+	fib_a->size += fib_b->size;
+
+	fib_b->head = fib_b->tail = fib_b->min_node = nullptr;
+	fib_b->size = 0;
+}
+
+template <typename T>
+FibonacciHeap<T>::FibonacciHeap (const int capacity) {
+	if (capacity > 0) {
+		PtrSlot block = newBlock(capacity);
+		for (int i = capacity - 1; i >= 0; i--) {
+			addFreeSlot(block + i);
+		}
+	}
+}
+
 template <typename T>
-FibonacciHeap<T>::FibonacciHeap (const int capacity) {}
+template <typename Iterator>
+FibonacciHeap<T>::FibonacciHeap (Iterator first, Iterator last) {
+	push_range(first, last);
+}
+
+template <typename T>
+FibonacciHeap<T>::~FibonacciHeap () {
+	clear();
+}
+
+template <typename T>
+void FibonacciHeap<T>::meld(FibonacciHeap&& other) {
+	merge(this, &other);
+}
+
+// By default all the consolidation is done by the pop() that follows a run of pushes.
+// With a positive budget every push() and pop() files or links at most max_steps roots,
+// keeping the partially built degree table between calls. 0 restores the default.
+// pop() still scans the roots for the new minimum, so the budget should be a few times
+// log2(size) to keep the pending roots from piling up.
+template <typename T>
+void FibonacciHeap<T>::setConsolidationBudget(int max_steps) {
+	resetConsolidation();
+	link_budget = max_steps > 0 ? max_steps : 0;
+}
 
 template <typename T>
 void FibonacciHeap<T>::clear() {
-	if (head == nullptr) {
-		return;
+	resetConsolidation();
+	if (!std::is_trivially_destructible<T>::value) {
+		destroyTrees(head);
 	}
-	// Delete all the trees one by one
-	for (PtrNode itr = head, nxt; itr != nullptr; itr = nxt) {
-		nxt = itr->next_sibling;
-		deleteTree(itr);
+	// Every node lives in one of the blocks
+	for (PtrSlot block : blocks) {
+		delete[] block;
 	}
+	blocks.clear();
+	head = tail = min_node = nullptr;
+	free_slots = nullptr;
+	size = 0;
 }
 
+// count free slots, so T needs no default constructor
 template <typename T>
-void FibonacciHeap<T>::deleteTree(PtrNode node) {
-	if (node == nullptr) {
-		return;
+typename FibonacciHeap<T>::PtrSlot FibonacciHeap<T>::newBlock(int count) {
+	PtrSlot block = new FibonacciSlot<T>[count];
+	blocks.push_back(block);
+	return block;
+}
+
+template <typename T>
+template <typename... Args>
+typename FibonacciHeap<T>::PtrNode FibonacciHeap<T>::allocateNode(Args&&... args) {
+	if (free_slots == nullptr) {
+		// Grow geometrically so that single pushes are amortized over few allocations
+		int count = std::max(16, size);
+		PtrSlot block = newBlock(count);
+		for (int i = count - 1; i >= 0; i--) {
+			addFreeSlot(block + i);
+		}
 	}
-	// Delete all the subtrees one by one
-	for (PtrNode itr = node->first_child, nxt; itr != nullptr; itr = nxt) {
-		nxt = itr->next_sibling;
-		deleteTree(itr);
+	PtrSlot slot = free_slots;
+	free_slots = slot->next_free;
+	return ::new (static_cast<void*>(&slot->node)) FibonacciNode<T>(std::forward<Args>(args)...);
+}
+
+template <typename T>
+void FibonacciHeap<T>::releaseNode(PtrNode node) {
+	node->~FibonacciNode();
+	addFreeSlot(reinterpret_cast<PtrSlot>(node));	// The node is a member of its slot
+}
+
+template <typename T>
+void FibonacciHeap<T>::addFreeSlot(PtrSlot slot) {
+	slot->next_free = free_slots;
+	free_slots = slot;
+}
+
+template <typename T>
+void FibonacciHeap<T>::destroyTrees(PtrNode node) {
+	while (node != nullptr) {
+		PtrNode next = node->next_sibling;
+		destroyTrees(node->first_child);
+		node->~FibonacciNode();
+		node = next;
 	}
-	delete node;
 }
 
 template <typename T>
-bool FibonacciHeap<T>::empty() {
+bool FibonacciHeap<T>::empty() const {
 	return head == nullptr;
 }
 
 // Push a new key into the heap
 template <typename T>
 typename FibonacciHeap<T>::PtrNode FibonacciHeap<T>::push(const T& key) {
+	return insertKey(key);
+}
+
+template <typename T>
+typename FibonacciHeap<T>::PtrNode FibonacciHeap<T>::push(T&& key) {
+	return insertKey(std::move(key));
+}
+
+template <typename T>
+template <typename... Args>
+typename FibonacciHeap<T>::PtrNode FibonacciHeap<T>::emplace(Args&&... args) {
+	return insertKey(std::forward<Args>(args)...);
+}
+
+template <typename T>
+template <typename... Args>
+typename FibonacciHeap<T>::PtrNode FibonacciHeap<T>::insertKey(Args&&... args) {
 	// Create a new tree
 	size++;
-	auto new_tree = new FibonacciNode<T>(key);
+	auto new_tree = allocateNode(std::forward<Args>(args)...);
 	// Insert the new tree among other trees
 	new_tree->next_sibling = head;
 	if (head != nullptr) {
 		head->prev_sibling = new_tree;
+	} else {
+		tail = new_tree;
 	}
 	head = new_tree;
+	if (min_node == nullptr || new_tree->key < min_node->key) {
+		min_node = new_tree;
+	}
+	if (link_budget) {
+		rearrangeBounded();
+	}
 	return new_tree;
 }
 
@@ -142,6 +332,10 @@ template <typename T>
 FibonacciNode<T>* FibonacciHeap<T>::decrease(PtrNode node, const T &key) {
 	node->key = key;
 	auto ret = node;
+	// A key smaller than the minimum is always cut below, so it ends up as a root
+	if (key < min_node->key) {
+		min_node = node;
+	}
 	// If this is a root or the change does not violate the heap order, do nothing
 	if (node->parent == nullptr || node->parent->key < key) {
 		return node;
@@ -172,6 +366,9 @@ FibonacciNode<T>* FibonacciHeap<T>::decrease(PtrNode node, const T &key) {
 			PtrNode tmp = node->parent;
 			node->parent = nullptr;
 			node = tmp;
+			if (link_budget && node->parent == nullptr) {
+				unfileRoot(node);	// Its rank is about to change
+			}
 			node->rank--;
 		} else {
 			break;
@@ -187,43 +384,181 @@ FibonacciNode<T>* FibonacciHeap<T>::decrease(PtrNode node, const T &key) {
 }
 
 template <typename T>
-T FibonacciHeap<T>::top() {
+const T& FibonacciHeap<T>::top() const {
 	// Did not check underflow!
-	rearrange();
-	PtrNode min_itr = head;
-	for (PtrNode itr = head->next_sibling; itr != nullptr; itr = itr->next_sibling) {
-		if (itr->key < min_itr->key) {
-			min_itr = itr;
-		}
-	}
-	return min_itr->key;
+	return min_node->key;
 }
 
 template <typename T>
 T FibonacciHeap<T>::pop() {
 	// Did not check underflow!
-	rearrange();
-	PtrNode min_itr = head;
-	for (PtrNode itr = head->next_sibling; itr != nullptr; itr = itr->next_sibling) {
-		if (itr->key < min_itr->key) {
-			min_itr = itr;
-		}
+	T min_key = std::move(min_node->key);
+	if (link_budget) {
+		unfileRoot(min_node);
 	}
-	T min_key = min_itr->key;
-	removeRoot(min_itr);
+	removeRoot(min_node);
 	size--;
+	if (link_budget) {
+		rearrangeBounded();
+		findMin();
+	} else {
+		rearrange();	// Also finds the new minimum
+	}
 	return min_key;
 }
 
+// Push all the keys at once, their nodes are allocated in a single block
+template <typename T>
+template <typename Iterator>
+void FibonacciHeap<T>::push_range(Iterator first, Iterator last) {
+	int count = std::distance(first, last);
+	if (count <= 0) {
+		return;
+	}
+	PtrSlot block = newBlock(count);
+	PtrNode prev = nullptr;
+	for (int i = 0; i < count; i++, ++first) {
+		PtrNode node = ::new (static_cast<void*>(&block[i].node)) FibonacciNode<T>(*first);
+		node->prev_sibling = prev;
+		node->next_sibling = (i + 1 < count) ? &block[i + 1].node : nullptr;
+		if (min_node == nullptr || node->key < min_node->key) {
+			min_node = node;
+		}
+		prev = node;
+	}
+
+	// Put the new trees in front of the others
+	prev->next_sibling = head;
+	if (head) {
+		head->prev_sibling = prev;
+	} else {
+		tail = prev;
+	}
+	head = &block[0].node;
+	size += count;
+	if (link_budget) {
+		rearrangeBounded();
+	}
+}
+
+// Consolidate once, then repeatedly take the smallest root out of a binary heap of candidates,
+// whose children become candidates in turn. The remaining candidates form the new root list.
+template <typename T>
+template <typename OutputIterator>
+OutputIterator FibonacciHeap<T>::pop_k(int k, OutputIterator out) {
+	if (k <= 0 || head == nullptr) {
+		return out;
+	}
+	resetConsolidation();
+	rearrange();
+
+	auto greater_key = [](PtrNode a, PtrNode b) { return b->key < a->key; };
+	std::vector<PtrNode> candidates;
+	for (PtrNode itr = head; itr != nullptr; itr = itr->next_sibling) {
+		candidates.push_back(itr);
+	}
+	std::make_heap(candidates.begin(), candidates.end(), greater_key);
+
+	for (; k > 0 && !candidates.empty(); k--) {
+		std::pop_heap(candidates.begin(), candidates.end(), greater_key);
+		PtrNode node = candidates.back();
+		candidates.pop_back();
+		*out++ = std::move(node->key);
+		for (PtrNode itr = node->first_child; itr != nullptr; itr = itr->next_sibling) {
+			itr->parent = nullptr;
+			itr->marked = false;
+			candidates.push_back(itr);
+			std::push_heap(candidates.begin(), candidates.end(), greater_key);
+		}
+		releaseNode(node);
+		size--;
+	}
+
+	// Link the remaining candidates into the root list
+	head = tail = nullptr;
+	for (PtrNode node : candidates) {
+		insertRootBefore(nullptr, node);
+	}
+	min_node = candidates.empty() ? nullptr : candidates.front();
+	return out;
+}
+
+template <typename T>
+void FibonacciHeap<T>::rearrangeBounded() {
+	for (int step = 0; step < link_budget; step++) {
+		// Take the last pending root
+		PtrNode cur = boundary ? boundary->prev_sibling : tail;
+		if (cur == nullptr) {
+			return;
+		}
+		if (degree_table.size() <= static_cast<size_t>(cur->rank)) {
+			degree_table.resize(cur->rank + 1, nullptr);
+		}
+		PtrNode& slot = degree_table[cur->rank];
+		if (slot == nullptr) {	// File it
+			slot = cur;
+			boundary = cur;
+			continue;
+		}
+
+		// Link it with the filed root of the same rank, the result is pending again
+		PtrNode other = slot;
+		slot = nullptr;
+		if (boundary == other) {
+			boundary = other->next_sibling;
+		}
+		unlinkRoot(cur);
+		unlinkRoot(other);
+		PtrNode carry = merge(cur, other);
+		if (min_node != carry && (min_node == cur || min_node == other)) {
+			min_node = carry;	// Equal keys
+		}
+		insertRootBefore(boundary, carry);
+	}
+}
+
+template <typename T>
+void FibonacciHeap<T>::resetConsolidation() {
+	for (PtrNode itr = boundary; itr != nullptr; itr = itr->next_sibling) {
+		degree_table[itr->rank] = nullptr;
+	}
+	boundary = nullptr;
+}
+
+template <typename T>
+void FibonacciHeap<T>::unfileRoot(PtrNode node) {
+	if (static_cast<size_t>(node->rank) >= degree_table.size() || degree_table[node->rank] != node) {
+		return;	// Still pending
+	}
+	degree_table[node->rank] = nullptr;
+	if (boundary == node) {
+		boundary = node->next_sibling;
+	} else {
+		unlinkRoot(node);
+		insertRootBefore(boundary, node);
+	}
+}
+
+template <typename T>
+void FibonacciHeap<T>::findMin() {
+	min_node = head;
+	for (PtrNode itr = head; itr != nullptr; itr = itr->next_sibling) {
+		if (itr->key < min_node->key) {
+			min_node = itr;
+		}
+	}
+}
+
 template <typename T>
 void FibonacciHeap<T>::rearrange() {
-	static PtrNode list_size_of[30];
 	static const double constant = std::log(1.5);
 	int max_rank = std::log(size + 1) / constant + 1;
+	if (degree_table.size() < static_cast<size_t>(max_rank + 1)) {
+		degree_table.resize(max_rank + 1, nullptr);	// Grows with size, entries stay null between calls
+	}
+	PtrNode* list_size_of = degree_table.data();
 
 	// Link all the trees of the same size
-	// PtrNode* list_size_of = new PtrNode[max_rank + 1];
-	// memset(list_size_of, 0, sizeof(PtrNode) * (max_rank + 1));
 	for (PtrNode itr = head, nxt; itr != nullptr; itr = nxt) {
 		nxt = itr->next_sibling;
 		PtrNode& list_head = list_size_of[itr->rank];
@@ -246,17 +581,22 @@ void FibonacciHeap<T>::rearrange() {
 		}
 	}
 
-	head = nullptr;
+	head = min_node = nullptr;
 	PtrNode prev = nullptr;	// The tree inserted last time
 	for (int i = 0; i < max_rank; i++) {
 		PtrNode cur = list_size_of[i];
 		if (cur == nullptr) {
 			continue;
 		}
+		if (min_node == nullptr || cur->key < min_node->key) {
+			min_node = cur;
+		}
 		cur->next_sibling = prev;
 		if (prev) {
 			prev->prev_sibling = cur;
 			// reverse the order, actually
+		} else {
+			tail = cur;
 		}
 		prev = cur;
 		list_size_of[i] = nullptr;
@@ -265,7 +605,6 @@ void FibonacciHeap<T>::rearrange() {
 	if (prev) {
 		prev->prev_sibling = nullptr;
 	}
-	// delete [] list_size_of;
 }
 
 template <typename T>
@@ -274,51 +613,67 @@ void FibonacciHeap<T>::insertTree(PtrNode node) {
 	node->prev_sibling = nullptr;
 	if (head != nullptr) {
 		head->prev_sibling = node;
+	} else {
+		tail = node;
 	}
 	head = node;
 }
 
+template <typename T>
+void FibonacciHeap<T>::unlinkRoot(PtrNode node) {
+	if (node->prev_sibling) {
+		node->prev_sibling->next_sibling = node->next_sibling;
+	} else {
+		head = node->next_sibling;
+	}
+	if (node->next_sibling) {
+		node->next_sibling->prev_sibling = node->prev_sibling;
+	} else {
+		tail = node->prev_sibling;
+	}
+	node->prev_sibling = node->next_sibling = nullptr;
+}
+
+template <typename T>
+void FibonacciHeap<T>::insertRootBefore(PtrNode pos, PtrNode node) {
+	node->next_sibling = pos;
+	node->prev_sibling = pos ? pos->prev_sibling : tail;
+	if (node->prev_sibling) {
+		node->prev_sibling->next_sibling = node;
+	} else {
+		head = node;
+	}
+	if (pos) {
+		pos->prev_sibling = node;
+	} else {
+		tail = node;
+	}
+}
+
 template <typename T>
 void FibonacciHeap<T>::removeRoot(PtrNode node) {
-	// if (node->prev_sibling != nullptr) {
-	// 	node->prev_sibling->next_sibling = node->next_sibling;
-	// }
-	// if (node->next_sibling != nullptr) {
-	// 	node->next_sibling->prev_sibling = node->prev_sibling;
-	// }
-	// if (head == node) {
-	// 	head = node->next_sibling;
-	// }
 	// cut the tree from the heap
+	unlinkRoot(node);
 
 	PtrNode last = nullptr, first = node->first_child;
 	for (PtrNode itr = first; itr != nullptr; itr = itr->next_sibling) {
 		last = itr;
 		itr->parent = nullptr;	// Make every subtree of the current node a tree
+		itr->marked = false;
 	}
 
-	// Merge the list back
+	// Put the subtrees in front of the other trees
 	if (first) {
-		first->prev_sibling = node->prev_sibling;
-		last->next_sibling = node->next_sibling;
-		if (node->prev_sibling) {
-			node->prev_sibling->next_sibling = first;
-		}
-		if (node->next_sibling) {
-			node->next_sibling->prev_sibling = last;
-		}
-	} else {
-		if (node->prev_sibling) {
-			node->prev_sibling->next_sibling = node->next_sibling;
-		}
-		if (node->next_sibling) {
-			node->next_sibling->prev_sibling = node->prev_sibling;
+		first->prev_sibling = nullptr;
+		last->next_sibling = head;
+		if (head) {
+			head->prev_sibling = last;
+		} else {
+			tail = last;
 		}
+		head = first;
 	}
-	if (head == node) {
-		head = first ? first : node->next_sibling;
-	}
-	delete node;
+	releaseNode(node);
 }
 
 template <typename T>
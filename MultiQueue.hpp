@@ -0,0 +1,197 @@
+#if !defined(MULTI_QUEUE_HPP)
+#define MULTI_QUEUE_HPP
+
+#include "PairHeap.hpp"
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include <utility>
+
+// Relaxed concurrent priority queue made of shards_per_thread * threads PairHeaps, each behind its own lock.
+// push() goes to a random shard, pop() takes the smallest top among `choices` random shards.
+// pop() therefore returns one of the smallest keys rather than the smallest; more shards and
+// fewer choices mean less contention and a looser order.
+template <typename T, PairingStrategy Strategy = PairingStrategy::TwoPass>
+class MultiQueue {
+public:
+	struct Counters {
+		uint64_t pushes = 0;
+		uint64_t pops = 0;
+		uint64_t lock_failures = 0;	// try_lock calls that found the shard busy
+		uint64_t empty_probes = 0;	// pop attempts whose chosen shards were all empty
+	};
+
+	static constexpr int MaxChoices = 8;
+
+	MultiQueue (int threads, int shards_per_thread = 2, int choices = 2);	// choices is clamped to [1, MaxChoices]
+
+	void push(const T& key);
+	void push(T&& key);
+	bool pop(T& key);	// false if every shard was found empty
+	bool empty() const;	// Safe at any time, but only exact when no other thread is working on the queue
+	int getShards() const;
+	Counters getCounters() const;
+	void resetCounters();
+
+private:
+	struct alignas(64) Shard {
+		std::mutex lock;
+		PairHeap<T, Strategy> heap;
+		std::atomic<int> size{0};	// Keys in heap, changed under lock so that empty() need not take it
+		std::atomic<uint64_t> pushes{0};
+		std::atomic<uint64_t> pops{0};
+		std::atomic<uint64_t> lock_failures{0};
+		std::atomic<uint64_t> empty_probes{0};
+	};
+
+	std::vector<Shard> shards;
+	int choices;
+
+	template <typename U>
+	void insertKey(U&& key);
+	static unsigned randomShard(unsigned count);
+};
+
+// Implementation below
+
+template <typename T, PairingStrategy Strategy>
+MultiQueue<T, Strategy>::MultiQueue (int threads, int shards_per_thread, int choices) :
+	shards(std::max(1, threads) * std::max(1, shards_per_thread)),
+	choices(std::min(MaxChoices, std::max(1, choices))) {}
+
+template <typename T, PairingStrategy Strategy>
+unsigned MultiQueue<T, Strategy>::randomShard(unsigned count) {
+	thread_local std::minstd_rand rng(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	return rng() % count;
+}
+
+template <typename T, PairingStrategy Strategy>
+int MultiQueue<T, Strategy>::getShards() const {
+	return shards.size();
+}
+
+template <typename T, PairingStrategy Strategy>
+void MultiQueue<T, Strategy>::push(const T& key) {
+	insertKey(key);
+}
+
+template <typename T, PairingStrategy Strategy>
+void MultiQueue<T, Strategy>::push(T&& key) {
+	insertKey(std::move(key));
+}
+
+template <typename T, PairingStrategy Strategy>
+template <typename U>
+void MultiQueue<T, Strategy>::insertKey(U&& key) {
+	while (true) {
+		Shard& shard = shards[randomShard(shards.size())];
+		if (!shard.lock.try_lock()) {
+			shard.lock_failures.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+		shard.heap.push(std::forward<U>(key));
+		shard.size.fetch_add(1, std::memory_order_release);
+		shard.pushes.fetch_add(1, std::memory_order_relaxed);
+		shard.lock.unlock();
+		return;
+	}
+}
+
+template <typename T, PairingStrategy Strategy>
+bool MultiQueue<T, Strategy>::pop(T& key) {
+	unsigned count = shards.size();
+	int d = std::min<int>(choices, count);
+	Shard* locked[MaxChoices];	// No allocation on the hot path
+
+	// Random probes first, they never block
+	for (unsigned attempt = 0; attempt < count; attempt++) {
+		int locked_count = 0;
+		for (int i = 0; i < d; i++) {
+			Shard& shard = shards[randomShard(count)];
+			bool duplicate = false;
+			for (int j = 0; j < locked_count; j++) {
+				duplicate = duplicate || locked[j] == &shard;
+			}
+			if (duplicate) {
+				continue;
+			}
+			if (shard.lock.try_lock()) {
+				locked[locked_count++] = &shard;
+			} else {
+				shard.lock_failures.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		Shard* best = nullptr;
+		for (int i = 0; i < locked_count; i++) {
+			Shard* shard = locked[i];
+			if (!shard->heap.empty() && (best == nullptr || shard->heap.top() < best->heap.top())) {
+				best = shard;
+			}
+		}
+		if (best) {
+			key = best->heap.pop();
+			best->size.fetch_sub(1, std::memory_order_release);
+			best->pops.fetch_add(1, std::memory_order_relaxed);
+		} else if (locked_count > 0) {
+			locked[0]->empty_probes.fetch_add(1, std::memory_order_relaxed);
+		}
+		for (int i = 0; i < locked_count; i++) {
+			locked[i]->lock.unlock();
+		}
+		if (best) {
+			return true;
+		}
+	}
+
+	// The queue looks empty, sweep every shard before giving up
+	for (Shard& shard : shards) {
+		std::lock_guard<std::mutex> guard(shard.lock);
+		if (!shard.heap.empty()) {
+			key = shard.heap.pop();
+			shard.size.fetch_sub(1, std::memory_order_release);
+			shard.pops.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename T, PairingStrategy Strategy>
+bool MultiQueue<T, Strategy>::empty() const {
+	for (const Shard& shard : shards) {
+		if (shard.size.load(std::memory_order_acquire) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename T, PairingStrategy Strategy>
+typename MultiQueue<T, Strategy>::Counters MultiQueue<T, Strategy>::getCounters() const {
+	Counters total;
+	for (const Shard& shard : shards) {
+		total.pushes += shard.pushes.load(std::memory_order_relaxed);
+		total.pops += shard.pops.load(std::memory_order_relaxed);
+		total.lock_failures += shard.lock_failures.load(std::memory_order_relaxed);
+		total.empty_probes += shard.empty_probes.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+template <typename T, PairingStrategy Strategy>
+void MultiQueue<T, Strategy>::resetCounters() {
+	for (Shard& shard : shards) {
+		shard.pushes.store(0, std::memory_order_relaxed);
+		shard.pops.store(0, std::memory_order_relaxed);
+		shard.lock_failures.store(0, std::memory_order_relaxed);
+		shard.empty_probes.store(0, std::memory_order_relaxed);
+	}
+}
+
+#endif // MULTI_QUEUE_HPP
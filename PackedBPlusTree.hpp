@@ -0,0 +1,849 @@
+#if !defined(PACKED_BPLUS_TREE_HPP)
+#define PACKED_BPLUS_TREE_HPP
+
+#include "BPlusTree.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+class PackedBPlusTree;
+
+// Fields of 8, 16 or 32 bits are whole bytes, so a leaf packed at one of these widths is searched
+// a vector at a time like BPlusSearch does. The fields are unsigned: flipping the top bit of both
+// sides turns the signed compare into an unsigned one.
+// upperBound: number of fields among the first n that are not > d, d must fit in Width bits.
+#if defined(__SSE2__)
+template <int Width>
+struct PackedSearch;
+
+template <>
+struct PackedSearch<8> {
+    static int upperBound(const uint8_t* packed, int n, uint8_t d) {
+        int pos = 0;
+#if defined(__AVX2__)
+        __m256i flip = _mm256_set1_epi8(static_cast<char>(0x80));
+        __m256i pivot = _mm256_set1_epi8(static_cast<char>(d ^ 0x80));
+        for (; pos + 32 <= n; pos += 32) {
+            __m256i lanes = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed + pos)), flip);
+            unsigned mask = _mm256_movemask_epi8(_mm256_cmpgt_epi8(lanes, pivot));
+            if (mask) {
+                return pos + __builtin_ctz(mask);
+            }
+        }
+#endif
+        __m128i flip16 = _mm_set1_epi8(static_cast<char>(0x80));
+        __m128i pivot16 = _mm_set1_epi8(static_cast<char>(d ^ 0x80));
+        for (; pos + 16 <= n; pos += 16) {
+            __m128i lanes = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + pos)), flip16);
+            int mask = _mm_movemask_epi8(_mm_cmpgt_epi8(lanes, pivot16));
+            if (mask) {
+                return pos + __builtin_ctz(mask);
+            }
+        }
+        while (pos < n && !(packed[pos] > d)) {
+            pos++;
+        }
+        return pos;
+    }
+};
+
+template <>
+struct PackedSearch<16> {
+    static int upperBound(const uint8_t* packed, int n, uint16_t d) {
+        int pos = 0;
+#if defined(__AVX2__)
+        __m256i flip = _mm256_set1_epi16(static_cast<short>(0x8000));
+        __m256i pivot = _mm256_set1_epi16(static_cast<short>(d ^ 0x8000));
+        for (; pos + 16 <= n; pos += 16) {
+            __m256i lanes = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed + 2 * pos)), flip);
+            unsigned mask = _mm256_movemask_epi8(_mm256_cmpgt_epi16(lanes, pivot));
+            if (mask) {
+                return pos + __builtin_ctz(mask) / 2;
+            }
+        }
+#endif
+        __m128i flip8 = _mm_set1_epi16(static_cast<short>(0x8000));
+        __m128i pivot8 = _mm_set1_epi16(static_cast<short>(d ^ 0x8000));
+        for (; pos + 8 <= n; pos += 8) {
+            __m128i lanes = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + 2 * pos)), flip8);
+            int mask = _mm_movemask_epi8(_mm_cmpgt_epi16(lanes, pivot8));
+            if (mask) {
+                return pos + __builtin_ctz(mask) / 2;
+            }
+        }
+        for (; pos < n; pos++) {
+            uint16_t field;
+            std::memcpy(&field, packed + 2 * pos, sizeof(field));
+            if (field > d) {
+                break;
+            }
+        }
+        return pos;
+    }
+};
+
+template <>
+struct PackedSearch<32> {
+    static int upperBound(const uint8_t* packed, int n, uint32_t d) {
+        int pos = 0;
+#if defined(__AVX2__)
+        __m256i flip = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+        __m256i pivot = _mm256_set1_epi32(static_cast<int>(d ^ 0x80000000u));
+        for (; pos + 8 <= n; pos += 8) {
+            __m256i lanes = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed + 4 * pos)), flip);
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(lanes, pivot)));
+            if (mask) {
+                return pos + __builtin_ctz(mask);
+            }
+        }
+#endif
+        __m128i flip4 = _mm_set1_epi32(static_cast<int>(0x80000000u));
+        __m128i pivot4 = _mm_set1_epi32(static_cast<int>(d ^ 0x80000000u));
+        for (; pos + 4 <= n; pos += 4) {
+            __m128i lanes = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + 4 * pos)), flip4);
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(lanes, pivot4)));
+            if (mask) {
+                return pos + __builtin_ctz(mask);
+            }
+        }
+        for (; pos < n; pos++) {
+            uint32_t field;
+            std::memcpy(&field, packed + 4 * pos, sizeof(field));
+            if (field > d) {
+                break;
+            }
+        }
+        return pos;
+    }
+};
+#endif // __SSE2__
+
+// Order: maximum number of childs
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+class PackedBPlusNode {
+public:
+    friend class PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>;
+protected:
+    bool leaf;
+    int n;          // Number of keys in the node
+};
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+class PackedBPlusInternal : public PackedBPlusNode<K, V, Order, LeafKeys, KeyBits> {
+public:
+    friend class PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>;
+protected:
+    alignas(sizeof(K) * (Order + 2) >= 64 ? 64 : alignof(K)) K key[Order + 2];
+    PackedBPlusNode<K, V, Order, LeafKeys, KeyBits>* child[Order + 2];
+    // child[i] < key[i] <= child[i + 1] < key[i + 1]
+};
+
+// Keys are stored as key - base in width bits each, packed back to back (frame of reference).
+// A leaf takes up to LeafKeys keys as long as they fit in LeafKeys * KeyBits bits.
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+class PackedBPlusLeaf : public PackedBPlusNode<K, V, Order, LeafKeys, KeyBits> {
+public:
+    friend class PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>;
+protected:
+    static constexpr int PackedBytes = (LeafKeys * KeyBits + 7) / 8;
+    K base;         // Not above the smallest key, erases leave it as it is
+    int width;      // Bits per key
+    // Padded so that any key can be read with one 8 byte load and one more byte
+    uint8_t packed[PackedBytes + 9];
+    V value[LeafKeys + 2];
+    // value[i] belongs to the i-th key
+    PackedBPlusLeaf* next = nullptr;    // Leaf holding the next larger keys
+};
+
+// B+ tree for integer keys with bit packed leaves. Internal nodes are the same as in BPlusTree.
+// Keys that are close together, such as mostly sorted ids, take a few bits each instead of
+// sizeof(K) bytes. Searches run on the packed keys, nothing is unpacked on the way.
+// A leaf that erases leave under half full, in keys and in bits, is merged with a sibling
+// when both fit in one leaf, otherwise the two share their keys out again.
+template <typename K, typename V, int Order, int LeafKeys = 4 * Order, int KeyBits = 16>
+class PackedBPlusTree {
+    static_assert(std::is_integral<K>::value, "Keys must be integers");
+    static_assert(sizeof(K) <= 8, "Keys must fit in 64 bits");
+    static_assert(Order >= 4, "Order must be at least 4");
+    static_assert(LeafKeys >= 2, "A leaf must hold at least two keys");
+    static_assert(KeyBits >= 1 && KeyBits <= 64, "KeyBits must be within [1, 64]");
+public:
+    using PtrNode = PackedBPlusNode<K, V, Order, LeafKeys, KeyBits>*;
+    using PtrInternal = PackedBPlusInternal<K, V, Order, LeafKeys, KeyBits>*;
+    using PtrLeaf = PackedBPlusLeaf<K, V, Order, LeafKeys, KeyBits>*;
+
+    // Forward iterator over the leaves, in key order. Keys are unpacked one at a time, so it
+    // dereferences to a pair of the key by value and a reference to the value.
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<K, V>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<K, V&>;
+        struct pointer {
+            reference pair;
+            reference* operator->() { return &pair; }
+        };
+
+        friend class PackedBPlusTree;
+        Iterator() : leaf(nullptr), pos(1) {}
+        const K& key() const { return current; }
+        V& value() const { return leaf->value[pos]; }
+        reference operator*() const { return reference(current, value()); }
+        pointer operator->() const { return pointer{**this}; }
+        Iterator& operator++();
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const Iterator& other) const { return leaf == other.leaf && pos == other.pos; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+    private:
+        PtrLeaf leaf;
+        int pos;
+        K current = K();
+        Iterator(PtrLeaf leaf, int pos);    // Skips to the next leaf if pos is past the end
+    };
+
+    PackedBPlusTree();
+    PackedBPlusTree(const PackedBPlusTree&) = delete;
+    PackedBPlusTree& operator=(const PackedBPlusTree&) = delete;
+    ~PackedBPlusTree();
+
+    void insert(const K& x, V value);   // Overwrites the value of an existing key
+    bool erase(const K& x);             // false if x was not in the tree
+    V* find(const K& x);                // nullptr if x is not in the tree
+    Iterator begin();
+    Iterator end();
+    Iterator lower_bound(const K& x);   // First key >= x
+
+    size_t getNodeCount() const;
+    size_t getBytes() const;            // Memory taken by the nodes
+
+private:
+    using U = typename std::make_unsigned<K>::type;
+
+    PtrNode root;
+    size_t leaves = 0;
+    size_t internals = 0;
+
+    void splitChild(PtrInternal cur, int pos);
+    void addChild(PtrInternal cur, int pos, const K& separator, PtrNode node);  // node goes right of child[pos]
+    void removeChild(PtrInternal cur, int pos);     // Drops key[pos] and child[pos + 1]
+    bool realErase(const K& x, PtrNode cur, bool& found);  // Whether cur is left underfull
+    void fixChild(PtrInternal cur, int pos);
+    void mergeChildren(PtrInternal cur, int pos);   // Internal nodes only
+    void rebalanceLeaves(PtrInternal cur, int pos); // child[pos] and child[pos + 1]
+    void growRoot();
+    void deleteSubtree(PtrNode cur);
+    PtrLeaf newLeaf();
+    PtrInternal newInternal();
+    void freeNode(PtrNode cur);
+    PtrLeaf findLeaf(const K& x);
+
+    static int upperBound(PtrNode cur, const K& x) {
+        return BPlusSearch<K>::upperBound(asInternal(cur)->key + 1, cur->n, x) + 1;
+    }
+    static int upperBound(PtrLeaf leaf, const K& x);    // First position whose key is > x
+    static uint64_t delta(const K& x, const K& base) {
+        return static_cast<uint64_t>(static_cast<U>(static_cast<U>(x) - static_cast<U>(base)));
+    }
+    static int widthOf(uint64_t range);
+    static uint64_t readBits(const uint8_t* packed, uint64_t bit, int width);
+    static void writeBits(uint8_t* packed, uint64_t bit, int width, uint64_t v);
+    static void moveBits(uint8_t* packed, uint64_t from, uint64_t to, uint64_t length);
+    static uint64_t extract(const uint8_t* packed, int width, int i) {     // The i-th (from 0) key field
+        return readBits(packed, static_cast<uint64_t>(i) * width, width);
+    }
+    static K keyAt(PtrLeaf leaf, int pos) {
+        return static_cast<K>(static_cast<U>(static_cast<U>(leaf->base) + static_cast<U>(extract(leaf->packed, leaf->width, pos - 1))));
+    }
+    static bool fits(const K* key, int first, int last);    // Whether key[first .. last] can share a leaf
+    static bool underfull(PtrNode cur);
+    static int splitPoint(const K* key, int n, bool append);
+    static void pack(PtrLeaf leaf, const K* key, int n);    // key[1 .. n]
+    static void unpack(PtrLeaf leaf, K* key);
+    static PtrInternal asInternal(PtrNode cur) { return static_cast<PtrInternal>(cur); }
+    static PtrLeaf asLeaf(PtrNode cur) { return static_cast<PtrLeaf>(cur); }
+};
+
+// Implementation below
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::PackedBPlusTree() {
+    root = newLeaf();
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::~PackedBPlusTree() {
+    deleteSubtree(root);
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::deleteSubtree(PtrNode cur) {
+    if (!cur->leaf) {
+        for (int i = 1; i <= cur->n + 1; i++) {
+            deleteSubtree(asInternal(cur)->child[i]);
+        }
+    }
+    freeNode(cur);
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+typename PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::PtrLeaf PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::newLeaf() {
+    PtrLeaf leaf = new PackedBPlusLeaf<K, V, Order, LeafKeys, KeyBits>;
+    leaf->leaf = true;
+    leaf->n = 0;
+    leaf->base = K();
+    leaf->width = 0;
+    std::memset(leaf->packed, 0, sizeof(leaf->packed));
+    leaves++;
+    return leaf;
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+typename PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::PtrInternal PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::newInternal() {
+    PtrInternal internal = new PackedBPlusInternal<K, V, Order, LeafKeys, KeyBits>;
+    internal->leaf = false;
+    internal->n = 0;
+    internals++;
+    return internal;
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::freeNode(PtrNode cur) {
+    if (cur->leaf) {
+        delete asLeaf(cur);
+        leaves--;
+    } else {
+        delete asInternal(cur);
+        internals--;
+    }
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+size_t PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::getNodeCount() const {
+    return leaves + internals;
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+size_t PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::getBytes() const {
+    return leaves * sizeof(PackedBPlusLeaf<K, V, Order, LeafKeys, KeyBits>)
+        + internals * sizeof(PackedBPlusInternal<K, V, Order, LeafKeys, KeyBits>);
+}
+
+// Bits needed to hold range
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+int PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::widthOf(uint64_t range) {
+#if defined(__GNUC__)
+    return range == 0 ? 0 : 64 - __builtin_clzll(range);
+#else
+    int width = 0;
+    for (; range; range >>= 1) {
+        width++;
+    }
+    return width;
+#endif
+}
+
+// The width bits starting at bit. Reads little endian: one unaligned load covers them
+// unless they start late in their first byte and are more than 56 bits wide.
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+uint64_t PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::readBits(const uint8_t* packed, uint64_t bit, int width) {
+    const uint8_t* first = packed + (bit >> 3);
+    int shift = bit & 7;
+    uint64_t word;
+    std::memcpy(&word, first, sizeof(word));
+    word >>= shift;
+    if (shift + width > 64) {
+        word |= static_cast<uint64_t>(first[8]) << (64 - shift);
+    }
+    return width == 64 ? word : word & ((static_cast<uint64_t>(1) << width) - 1);
+}
+
+// Overwrite the width bits starting at bit with v, which must fit in width bits
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::writeBits(uint8_t* packed, uint64_t bit, int width, uint64_t v) {
+    uint8_t* first = packed + (bit >> 3);
+    int shift = bit & 7;
+    uint64_t mask = width == 64 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << width) - 1;
+    uint64_t word;
+    std::memcpy(&word, first, sizeof(word));
+    word = (word & ~(mask << shift)) | (v << shift);
+    std::memcpy(first, &word, sizeof(word));
+    if (shift + width > 64) {
+        first[8] = static_cast<uint8_t>((first[8] & ~(mask >> (64 - shift))) | (v >> (64 - shift)));
+    }
+}
+
+// memmove for bits, 56 at a time so that each piece is a single load and store
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::moveBits(uint8_t* packed, uint64_t from, uint64_t to, uint64_t length) {
+    const uint64_t Piece = 56;
+    if (to > from) {
+        // Moving up, start from the top so nothing is overwritten before it is read
+        for (uint64_t end = length; end > 0;) {
+            int size = static_cast<int>(std::min(Piece, end));
+            end -= size;
+            writeBits(packed, to + end, size, readBits(packed, from + end, size));
+        }
+    } else {
+        for (uint64_t start = 0; start < length; start += Piece) {
+            int size = static_cast<int>(std::min(Piece, length - start));
+            writeBits(packed, to + start, size, readBits(packed, from + start, size));
+        }
+    }
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::pack(PtrLeaf leaf, const K* key, int n) {
+    leaf->n = n;
+    if (n == 0) {
+        leaf->width = 0;
+        return;
+    }
+    leaf->base = key[1];
+    leaf->width = widthOf(delta(key[n], key[1]));
+#if defined(__SSE2__)
+    // The leaf has room for LeafKeys * KeyBits bits either way, so rounding up to whole bytes
+    // costs no memory when the keys still fit, and lets upperBound use PackedSearch
+    for (int aligned : {8, 16, 32}) {
+        if (leaf->width <= aligned) {
+            if (static_cast<int64_t>(n) * aligned <= LeafKeys * KeyBits) {
+                leaf->width = aligned;
+            }
+            break;
+        }
+    }
+#endif
+    for (int i = 0; i < n; i++) {
+        writeBits(leaf->packed, static_cast<uint64_t>(i) * leaf->width, leaf->width, delta(key[i + 1], leaf->base));
+    }
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::unpack(PtrLeaf leaf, K* key) {
+    for (int i = 1; i <= leaf->n; i++) {
+        key[i] = keyAt(leaf, i);
+    }
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+bool PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::fits(const K* key, int first, int last) {
+    int count = last - first + 1;
+    return count <= LeafKeys && static_cast<int64_t>(count) * widthOf(delta(key[last], key[first])) <= LeafKeys * KeyBits;
+}
+
+// A leaf of wide keys holds fewer of them, so it counts as underfull only when it is under
+// half full both in keys and in bits
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+bool PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::underfull(PtrNode cur) {
+    if (!cur->leaf) {
+        return cur->n < Order / 2 - 1;
+    }
+    PtrLeaf leaf = asLeaf(cur);
+    return 2 * leaf->n < LeafKeys && 2 * static_cast<int64_t>(leaf->n) * leaf->width < LeafKeys * KeyBits;
+}
+
+// Where to cut key[1 .. n] that do not fit one leaf: [1, mid] and [mid + 1, n].
+// The keys without the new one fitted, and the new key either stays within their range
+// (then either half fits) or stretches it at one end (then it can go alone), so a cut always exists.
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+int PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::splitPoint(const K* key, int n, bool append) {
+    // Keys arriving in order leave full leaves behind them
+    if (append && fits(key, 1, n - 1)) {
+        return n - 1;
+    }
+    for (int d = 0; d < n; d++) {
+        for (int mid : {n / 2 - d, n / 2 + d}) {
+            if (mid >= 1 && mid < n && fits(key, 1, mid) && fits(key, mid + 1, n)) {
+                return mid;
+            }
+        }
+    }
+    return n / 2;
+}
+
+// Same branchless search as BPlusSearch, on the packed distances from the base
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+int PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::upperBound(PtrLeaf leaf, const K& x) {
+    if (leaf->n == 0 || leaf->base > x) {
+        return 1;
+    }
+    uint64_t d = delta(x, leaf->base);
+#if defined(__SSE2__)
+    // Every field is <= 2^width - 1, a larger d is past all of them
+    switch (leaf->width) {
+    case 8:
+        return (d >= 0xff ? leaf->n : PackedSearch<8>::upperBound(leaf->packed, leaf->n, static_cast<uint8_t>(d))) + 1;
+    case 16:
+        return (d >= 0xffff ? leaf->n : PackedSearch<16>::upperBound(leaf->packed, leaf->n, static_cast<uint16_t>(d))) + 1;
+    case 32:
+        return (d >= 0xffffffff ? leaf->n : PackedSearch<32>::upperBound(leaf->packed, leaf->n, static_cast<uint32_t>(d))) + 1;
+    }
+#endif
+    int first = 0;
+    int n = leaf->n;
+    while (n > 1) {
+        int half = n / 2;
+        first = extract(leaf->packed, leaf->width, first + half) > d ? first : first + half;
+        n -= half;
+    }
+    return first + !(extract(leaf->packed, leaf->width, first) > d) + 1;
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+typename PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::PtrLeaf PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::findLeaf(const K& x) {
+    PtrNode cur = root;
+    while (!cur->leaf) {
+        cur = asInternal(cur)->child[upperBound(cur, x)];
+    }
+    return asLeaf(cur);
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+V* PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::find(const K& x) {
+    PtrLeaf leaf = findLeaf(x);
+    int pos = upperBound(leaf, x);
+    if (pos > 1 && keyAt(leaf, pos - 1) == x) {
+        return &leaf->value[pos - 1];
+    }
+    return nullptr;
+}
+
+// Internal nodes are split on the way down as in BPlusTree. A key that fits the leaf's base and
+// width moves the fields after it up in place; otherwise the leaf is unpacked, takes the key and
+// is packed again, in two leaves if it no longer fits one.
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::insert(const K& x, V value) {
+    if (!root->leaf && root->n == Order - 1) {
+        growRoot();
+    }
+    PtrNode cur = root;
+    PtrInternal parent = nullptr;
+    int pos = 0;
+    while (!cur->leaf) {
+        parent = asInternal(cur);
+        pos = upperBound(cur, x);
+        PtrNode child = parent->child[pos];
+        if (!child->leaf && child->n == Order - 1) {
+            splitChild(parent, pos);
+            if (!(parent->key[pos] > x)) {
+                pos++;
+            }
+        }
+        cur = parent->child[pos];
+    }
+
+    PtrLeaf leaf = asLeaf(cur);
+    int leaf_pos = upperBound(leaf, x);
+    if (leaf_pos > 1 && keyAt(leaf, leaf_pos - 1) == x) {
+        leaf->value[leaf_pos - 1] = std::move(value);
+        return;
+    }
+    if (leaf->n > 0 && leaf->n < LeafKeys && !(leaf->base > x) && widthOf(delta(x, leaf->base)) <= leaf->width
+        && static_cast<int64_t>(leaf->n + 1) * leaf->width <= LeafKeys * KeyBits) {
+        uint64_t bit = static_cast<uint64_t>(leaf_pos - 1) * leaf->width;
+        moveBits(leaf->packed, bit, bit + leaf->width, static_cast<uint64_t>(leaf->n - leaf_pos + 1) * leaf->width);
+        writeBits(leaf->packed, bit, leaf->width, delta(x, leaf->base));
+        for (int i = leaf->n; i >= leaf_pos; i--) {
+            leaf->value[i + 1] = std::move(leaf->value[i]);
+        }
+        leaf->value[leaf_pos] = std::move(value);
+        leaf->n++;
+        return;
+    }
+    K key[LeafKeys + 2];
+    unpack(leaf, key);
+    int n = leaf->n + 1;
+    for (int i = n - 1; i >= leaf_pos; i--) {
+        key[i + 1] = key[i];
+        leaf->value[i + 1] = std::move(leaf->value[i]);
+    }
+    key[leaf_pos] = x;
+    leaf->value[leaf_pos] = std::move(value);
+    if (fits(key, 1, n)) {
+        pack(leaf, key, n);
+        return;
+    }
+
+    int mid = splitPoint(key, n, leaf->next == nullptr && leaf_pos == n);
+    PtrLeaf new_leaf = newLeaf();
+    for (int i = mid + 1; i <= n; i++) {
+        new_leaf->value[i - mid] = std::move(leaf->value[i]);
+    }
+    pack(new_leaf, key + mid, n - mid);
+    pack(leaf, key, mid);
+    new_leaf->next = leaf->next;
+    leaf->next = new_leaf;
+    if (parent == nullptr) {
+        PtrInternal new_root = newInternal();
+        new_root->child[1] = leaf;
+        addChild(new_root, 1, key[mid + 1], new_leaf);
+        root = new_root;
+    } else {
+        addChild(parent, pos, key[mid + 1], new_leaf);
+    }
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+bool PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::erase(const K& x) {
+    bool found = false;
+    realErase(x, root, found);
+    if (!root->leaf && root->n == 0) {
+        // The root lost its last separator, its only child becomes the root
+        PtrNode old_root = root;
+        root = asInternal(root)->child[1];
+        freeNode(old_root);
+    }
+    return found;
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+bool PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::realErase(const K& x, PtrNode cur, bool& found) {
+    if (cur->leaf) {
+        PtrLeaf leaf = asLeaf(cur);
+        int pos = upperBound(leaf, x);
+        if (pos == 1 || keyAt(leaf, pos - 1) != x) {
+            return false;
+        }
+        found = true;
+        // The base stays below the remaining keys, so the fields after x just move down in place
+        uint64_t bit = static_cast<uint64_t>(pos - 1) * leaf->width;
+        moveBits(leaf->packed, bit, bit - leaf->width, static_cast<uint64_t>(leaf->n - pos + 1) * leaf->width);
+        for (int i = pos; i <= leaf->n; i++) {
+            leaf->value[i - 1] = std::move(leaf->value[i]);
+        }
+        leaf->n--;
+    } else {
+        int pos = upperBound(cur, x);
+        if (realErase(x, asInternal(cur)->child[pos], found)) {
+            fixChild(asInternal(cur), pos);
+        }
+    }
+    return found && underfull(cur);
+}
+
+// child[pos] is underfull. Leaves pair up with a sibling, internal nodes take a key from
+// a sibling that can spare one or merge with it, as in BPlusTree::fixChild
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::fixChild(PtrInternal cur, int pos) {
+    if (cur->child[pos]->leaf) {
+        rebalanceLeaves(cur, pos > 1 ? pos - 1 : pos);
+        return;
+    }
+    PtrInternal node = asInternal(cur->child[pos]);
+    PtrInternal left = pos > 1 ? asInternal(cur->child[pos - 1]) : nullptr;
+    PtrInternal right = pos <= cur->n ? asInternal(cur->child[pos + 1]) : nullptr;
+    int min_keys = Order / 2 - 1;
+
+    if (left != nullptr && left->n > min_keys) {
+        // Shift node right by one and move the last child of left in front
+        for (int i = node->n; i >= 1; i--) {
+            node->key[i + 1] = node->key[i];
+        }
+        for (int i = node->n + 1; i >= 1; i--) {
+            node->child[i + 1] = node->child[i];
+        }
+        node->key[1] = cur->key[pos - 1];
+        node->child[1] = left->child[left->n + 1];
+        cur->key[pos - 1] = left->key[left->n];
+        node->n++;
+        left->n--;
+    } else if (right != nullptr && right->n > min_keys) {
+        // Move the first child of right to the end of node
+        node->key[node->n + 1] = cur->key[pos];
+        node->child[node->n + 2] = right->child[1];
+        cur->key[pos] = right->key[1];
+        for (int i = 2; i <= right->n; i++) {
+            right->key[i - 1] = right->key[i];
+        }
+        for (int i = 2; i <= right->n + 1; i++) {
+            right->child[i - 1] = right->child[i];
+        }
+        node->n++;
+        right->n--;
+    } else if (left != nullptr) {
+        mergeChildren(cur, pos - 1);
+    } else {
+        mergeChildren(cur, pos);
+    }
+}
+
+// Append internal child[pos + 1] to child[pos] and drop it together with the separator between them
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::mergeChildren(PtrInternal cur, int pos) {
+    PtrInternal left = asInternal(cur->child[pos]);
+    PtrInternal right = asInternal(cur->child[pos + 1]);
+    left->key[left->n + 1] = cur->key[pos];
+    for (int i = 1; i <= right->n; i++) {
+        left->key[left->n + 1 + i] = right->key[i];
+    }
+    for (int i = 1; i <= right->n + 1; i++) {
+        left->child[left->n + 1 + i] = right->child[i];
+    }
+    left->n += right->n + 1;
+    freeNode(right);
+    removeChild(cur, pos);
+}
+
+// Merge leaves child[pos] and child[pos + 1] if their keys fit in one, otherwise cut their
+// keys again where both halves fit and are closest in size. The old cut fits, so a cut exists.
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::rebalanceLeaves(PtrInternal cur, int pos) {
+    PtrLeaf left = asLeaf(cur->child[pos]);
+    PtrLeaf right = asLeaf(cur->child[pos + 1]);
+    K key[2 * LeafKeys + 2];
+    unpack(left, key);
+    unpack(right, key + left->n);
+    int n = left->n + right->n;
+
+    if (fits(key, 1, n)) {
+        for (int i = 1; i <= right->n; i++) {
+            left->value[left->n + i] = std::move(right->value[i]);
+        }
+        pack(left, key, n);
+        left->next = right->next;
+        freeNode(right);
+        removeChild(cur, pos);
+        return;
+    }
+
+    int mid = splitPoint(key, n, false);
+    if (mid > left->n) {
+        // The first keys of right move to the end of left
+        int moved = mid - left->n;
+        for (int i = 1; i <= moved; i++) {
+            left->value[left->n + i] = std::move(right->value[i]);
+        }
+        for (int i = moved + 1; i <= right->n; i++) {
+            right->value[i - moved] = std::move(right->value[i]);
+        }
+    } else if (mid < left->n) {
+        // The last keys of left move to the front of right
+        int moved = left->n - mid;
+        for (int i = right->n; i >= 1; i--) {
+            right->value[i + moved] = std::move(right->value[i]);
+        }
+        for (int i = 1; i <= moved; i++) {
+            right->value[i] = std::move(left->value[mid + i]);
+        }
+    }
+    pack(left, key, mid);
+    pack(right, key + mid, n - mid);
+    cur->key[pos] = key[mid + 1];
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::growRoot() {
+    PtrInternal new_root = newInternal();
+    new_root->child[1] = root;
+    splitChild(new_root, 1);
+    root = new_root;
+}
+
+// Only internal nodes, a full one (Order - 1 keys) is partitioned as in BPlusTree::splitChild
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::splitChild(PtrInternal cur, int pos) {
+    PtrInternal old_internal = asInternal(cur->child[pos]);
+    int n = old_internal->n;
+    int mid = (n + 1) / 2;
+    PtrInternal new_internal = newInternal();
+    for (int i = mid + 1; i <= n; i++) {
+        new_internal->key[i - mid] = old_internal->key[i];
+    }
+    for (int i = mid + 1; i <= n + 1; i++) {
+        new_internal->child[i - mid] = old_internal->child[i];
+    }
+    new_internal->n = n - mid;
+    old_internal->n = mid - 1;
+    addChild(cur, pos, old_internal->key[mid], new_internal);
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::addChild(PtrInternal cur, int pos, const K& separator, PtrNode node) {
+    for (int i = cur->n; i >= pos; i--) {
+        cur->key[i + 1] = cur->key[i];
+    }
+    for (int i = cur->n + 1; i > pos; i--) {
+        cur->child[i + 1] = cur->child[i];
+    }
+    (cur->n)++;
+    cur->key[pos] = separator;
+    cur->child[pos + 1] = node;
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+void PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::removeChild(PtrInternal cur, int pos) {
+    for (int i = pos + 1; i <= cur->n; i++) {
+        cur->key[i - 1] = cur->key[i];
+    }
+    for (int i = pos + 2; i <= cur->n + 1; i++) {
+        cur->child[i - 1] = cur->child[i];
+    }
+    cur->n--;
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::Iterator::Iterator(PtrLeaf leaf, int pos) : leaf(leaf), pos(pos) {
+    while (this->leaf != nullptr && this->pos > this->leaf->n) {
+        this->leaf = this->leaf->next;
+        this->pos = 1;
+    }
+    if (this->leaf != nullptr) {
+        current = keyAt(this->leaf, this->pos);
+    }
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+typename PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::Iterator& PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::Iterator::operator++() {
+    if (++pos > leaf->n) {
+        do {
+            leaf = leaf->next;
+            pos = 1;
+        } while (leaf != nullptr && leaf->n == 0);
+        if (leaf == nullptr) {
+            return *this;
+        }
+#if defined(__GNUC__)
+        // A scan touches the leaves one after another, start loading the one after this
+        if (leaf->next != nullptr) {
+            __builtin_prefetch(leaf->next);
+        }
+#endif
+    }
+    current = keyAt(leaf, pos);
+    return *this;
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+typename PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::Iterator PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::begin() {
+    PtrNode cur = root;
+    while (!cur->leaf) {
+        cur = asInternal(cur)->child[1];
+    }
+    return Iterator(asLeaf(cur), 1);
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+typename PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::Iterator PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::end() {
+    return Iterator(nullptr, 1);
+}
+
+template <typename K, typename V, int Order, int LeafKeys, int KeyBits>
+typename PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::Iterator PackedBPlusTree<K, V, Order, LeafKeys, KeyBits>::lower_bound(const K& x) {
+    // Every key >= x is in this leaf or further right
+    PtrLeaf leaf = findLeaf(x);
+    int pos = upperBound(leaf, x);
+    if (pos > 1 && keyAt(leaf, pos - 1) == x) {
+        pos--;
+    }
+    return Iterator(leaf, pos);
+}
+
+#endif // PACKED_BPLUS_TREE_HPP
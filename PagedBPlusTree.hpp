@@ -0,0 +1,481 @@
+#if !defined(PAGED_BPLUS_TREE_HPP)
+#define PAGED_BPLUS_TREE_HPP
+
+#include "BPlusTree.hpp"
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <new>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Fixed number of page frames over a file, pages are read with pread and written back with pwrite.
+// A frame is pinned while someone works on its page, unpinned frames are evicted least recently used first.
+template <int PageSize>
+class PageBufferPool {
+public:
+    using PageId = uint64_t;
+    struct Frame {
+        PageId id;
+        int pins;
+        bool dirty;
+        char* data;
+        typename std::list<Frame*>::iterator lru_pos;
+    };
+
+    PageBufferPool(int fd, int capacity);
+    PageBufferPool(const PageBufferPool&) = delete;
+    PageBufferPool& operator=(const PageBufferPool&) = delete;
+    ~PageBufferPool();
+
+    Frame* fetch(PageId id);        // Pinned, read from the file if it is not cached
+    Frame* create(PageId id);       // Pinned and zeroed, the file is not read
+    void unpin(Frame* frame, bool dirty);
+    void flush();                   // Write back every dirty page
+
+    // pread/pwrite all of [buffer, buffer + length), reading past the end of the file gives zeros
+    static void transfer(bool write, int fd, void* buffer, size_t length, off_t offset);
+
+private:
+    int fd;
+    std::vector<Frame> frames;
+    std::vector<Frame*> free_frames;
+    std::list<Frame*> lru;          // Most recently used first
+    std::unordered_map<PageId, Frame*> table;
+    char* memory;
+
+    Frame* grab(PageId id);         // A free frame, or the least recently used unpinned one
+    void release(Frame* frame);     // Forget the page of a frame and make it free
+    void write(Frame* frame);
+};
+
+// B+ tree whose nodes are PageSize pages of a file, children are linked by page ID.
+// Page 0 holds the root ID and the page count, so reopening the file only reads that page.
+// Only pool_pages pages are in memory at a time, the tree can be larger than RAM.
+// Changes reach the file when their pages are evicted or on flush(); flush() also writes page 0.
+// The file is not crash safe: pages are overwritten in place, so after a crash between two
+// flush() calls, or during one, page 0 can point into half updated pages. The file is only
+// consistent once flush() has returned.
+// Keys and values are copied to disk byte for byte, they must be trivially copyable.
+template <typename K, typename V, int PageSize = 4096>
+class PagedBPlusTree {
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "PagedBPlusTree stores keys and values as raw bytes");
+public:
+    using PageId = uint64_t;
+
+    // Opens the file, or creates it. An insert pins a whole path plus two pages, so pool_pages
+    // must be at least the height of the tree plus 2.
+    PagedBPlusTree(const std::string& path, int pool_pages = 1024);
+    PagedBPlusTree(const PagedBPlusTree&) = delete;
+    PagedBPlusTree& operator=(const PagedBPlusTree&) = delete;
+    ~PagedBPlusTree();      // Flushes
+
+    void insert(const K& x, const V& value);    // Overwrites the value of an existing key
+    bool find(const K& x, V& value);
+    uint64_t getSize() const;
+    void flush();
+
+private:
+    using Pool = PageBufferPool<PageSize>;
+    using Frame = typename Pool::Frame;
+
+    struct PageHeader {
+        uint32_t leaf;
+        uint32_t n;             // Number of keys in the page
+        PageId next;            // Next leaf, 0 if none
+    };
+    // One slot is left over for the padding between the two arrays
+    static const int LeafOrder = (PageSize - sizeof(PageHeader)) / (sizeof(K) + sizeof(V)) - 3;
+    static const int InternalOrder = (PageSize - sizeof(PageHeader)) / (sizeof(K) + sizeof(PageId)) - 3;
+    static_assert(LeafOrder >= 3 && InternalOrder >= 3, "PageSize is too small for these keys and values");
+
+    // Same layout rules as BPlusNode: 1-indexed, child[i] < key[i] <= child[i + 1]
+    struct LeafPage : PageHeader {
+        K key[LeafOrder + 2];
+        V value[LeafOrder + 2];
+    };
+    struct InternalPage : PageHeader {
+        K key[InternalOrder + 2];
+        PageId child[InternalOrder + 2];
+    };
+    static_assert(sizeof(LeafPage) <= PageSize && sizeof(InternalPage) <= PageSize, "Node does not fit in a page");
+
+    struct MetaPage {
+        uint64_t magic;
+        uint32_t page_size;
+        uint32_t key_size;
+        uint32_t value_size;
+        uint32_t reserved;
+        PageId root;
+        PageId page_count;
+        uint64_t size;
+    };
+    static const uint64_t Magic = 0x31454552545042ull;     // "BPTREE1"
+
+    int fd;
+    MetaPage meta;
+    Pool* pool = nullptr;
+    int pool_pages;
+    int height;             // Levels, a lone leaf is 1
+
+    Frame* newPage(bool leaf);
+    int treeHeight();
+    bool realInsert(const K& x, const V& value, PageId id);
+    void splitChild(InternalPage* cur, int pos);
+    static PageHeader* header(Frame* frame) { return reinterpret_cast<PageHeader*>(frame->data); }
+    static LeafPage* asLeaf(Frame* frame) { return reinterpret_cast<LeafPage*>(frame->data); }
+    static InternalPage* asInternal(Frame* frame) { return reinterpret_cast<InternalPage*>(frame->data); }
+    static int upperBound(const PageHeader* page, const K* key, const K& x) {
+        return BPlusSearch<K>::upperBound(key + 1, page->n, x) + 1;
+    }
+};
+
+// Implementation below
+
+template <int PageSize>
+PageBufferPool<PageSize>::PageBufferPool(int fd, int capacity) : fd(fd), frames(capacity > 0 ? capacity : 1) {
+    memory = static_cast<char*>(::operator new(frames.size() * PageSize, std::align_val_t(PageSize)));
+    for (size_t i = 0; i < frames.size(); i++) {
+        frames[i].id = 0;
+        frames[i].pins = 0;
+        frames[i].dirty = false;
+        frames[i].data = memory + i * PageSize;
+        frames[i].lru_pos = lru.end();
+        free_frames.push_back(&frames[i]);
+    }
+}
+
+template <int PageSize>
+PageBufferPool<PageSize>::~PageBufferPool() {
+    ::operator delete(memory, std::align_val_t(PageSize));
+}
+
+template <int PageSize>
+void PageBufferPool<PageSize>::transfer(bool write, int fd, void* buffer, size_t length, off_t offset) {
+    char* bytes = static_cast<char*>(buffer);
+    while (length > 0) {
+        ssize_t done = write ? pwrite(fd, bytes, length, offset) : pread(fd, bytes, length, offset);
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+        if (done < 0) {
+            throw std::system_error(errno, std::generic_category(), write ? "pwrite" : "pread");
+        }
+        if (done == 0) {
+            // Only a read can get here: the rest of the page is past the end of the file
+            std::memset(bytes, 0, length);
+            return;
+        }
+        bytes += done;
+        length -= done;
+        offset += done;
+    }
+}
+
+template <int PageSize>
+void PageBufferPool<PageSize>::write(Frame* frame) {
+    transfer(true, fd, frame->data, PageSize, static_cast<off_t>(frame->id) * PageSize);
+    frame->dirty = false;
+}
+
+template <int PageSize>
+typename PageBufferPool<PageSize>::Frame* PageBufferPool<PageSize>::grab(PageId id) {
+    Frame* frame = nullptr;
+    if (!free_frames.empty()) {
+        frame = free_frames.back();
+        free_frames.pop_back();
+    } else {
+        for (auto itr = lru.rbegin(); itr != lru.rend(); ++itr) {
+            if ((*itr)->pins == 0) {
+                frame = *itr;
+                break;
+            }
+        }
+        if (frame == nullptr) {
+            throw std::runtime_error("PageBufferPool: every frame is pinned");
+        }
+        if (frame->dirty) {
+            write(frame);
+        }
+        table.erase(frame->id);
+        lru.erase(frame->lru_pos);
+    }
+    frame->id = id;
+    frame->pins = 1;
+    frame->dirty = false;
+    lru.push_front(frame);
+    frame->lru_pos = lru.begin();
+    table[id] = frame;
+    return frame;
+}
+
+template <int PageSize>
+typename PageBufferPool<PageSize>::Frame* PageBufferPool<PageSize>::fetch(PageId id) {
+    auto found = table.find(id);
+    if (found != table.end()) {
+        Frame* frame = found->second;
+        frame->pins++;
+        lru.splice(lru.begin(), lru, frame->lru_pos);
+        return frame;
+    }
+    Frame* frame = grab(id);
+    try {
+        transfer(false, fd, frame->data, PageSize, static_cast<off_t>(id) * PageSize);
+    } catch (...) {
+        release(frame);
+        throw;
+    }
+    return frame;
+}
+
+template <int PageSize>
+void PageBufferPool<PageSize>::release(Frame* frame) {
+    table.erase(frame->id);
+    lru.erase(frame->lru_pos);
+    frame->pins = 0;
+    frame->dirty = false;
+    free_frames.push_back(frame);
+}
+
+template <int PageSize>
+typename PageBufferPool<PageSize>::Frame* PageBufferPool<PageSize>::create(PageId id) {
+    Frame* frame = grab(id);
+    std::memset(frame->data, 0, PageSize);
+    frame->dirty = true;
+    return frame;
+}
+
+template <int PageSize>
+void PageBufferPool<PageSize>::unpin(Frame* frame, bool dirty) {
+    frame->pins--;
+    frame->dirty = frame->dirty || dirty;
+}
+
+template <int PageSize>
+void PageBufferPool<PageSize>::flush() {
+    for (auto& entry : table) {
+        if (entry.second->dirty) {
+            write(entry.second);
+        }
+    }
+}
+
+template <typename K, typename V, int PageSize>
+PagedBPlusTree<K, V, PageSize>::PagedBPlusTree(const std::string& path, int pool_pages) : pool_pages(pool_pages) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+    off_t length = lseek(fd, 0, SEEK_END);
+    if (length < 0) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "lseek " + path);
+    }
+    try {
+        if (length > 0) {
+            Pool::transfer(false, fd, &meta, sizeof(meta), 0);
+            if (meta.magic != Magic || meta.page_size != PageSize || meta.key_size != sizeof(K) || meta.value_size != sizeof(V)) {
+                throw std::runtime_error(path + " is not a PagedBPlusTree file of this type");
+            }
+        }
+        pool = new Pool(fd, pool_pages);
+        height = length > 0 ? treeHeight() : 1;
+        if (pool_pages < height + 2) {
+            throw std::invalid_argument("PagedBPlusTree: pool_pages must be at least " + std::to_string(height + 2) + " for " + path);
+        }
+    } catch (...) {
+        delete pool;
+        close(fd);
+        throw;
+    }
+    if (length == 0) {
+        meta = MetaPage{Magic, PageSize, sizeof(K), sizeof(V), 0, 0, 1, 0};
+        Frame* root = newPage(true);
+        meta.root = root->id;
+        pool->unpin(root, true);
+        flush();
+    }
+}
+
+template <typename K, typename V, int PageSize>
+PagedBPlusTree<K, V, PageSize>::~PagedBPlusTree() {
+    try {
+        flush();
+    } catch (...) {
+        // Nothing sensible to do with a failed write here, call flush() first to see the error
+    }
+    delete pool;
+    close(fd);
+}
+
+template <typename K, typename V, int PageSize>
+void PagedBPlusTree<K, V, PageSize>::flush() {
+    // The pages go to disk before page 0 refers to them, so a page 0 on disk never counts
+    // pages the file does not have yet
+    pool->flush();
+    if (fdatasync(fd) != 0) {
+        throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+    // Only the header of page 0 is written, the rest of the page is never read
+    Pool::transfer(true, fd, &meta, sizeof(meta), 0);
+    if (fdatasync(fd) != 0) {
+        throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+}
+
+template <typename K, typename V, int PageSize>
+uint64_t PagedBPlusTree<K, V, PageSize>::getSize() const {
+    return meta.size;
+}
+
+template <typename K, typename V, int PageSize>
+typename PagedBPlusTree<K, V, PageSize>::Frame* PagedBPlusTree<K, V, PageSize>::newPage(bool leaf) {
+    Frame* frame = pool->create(meta.page_count++);
+    header(frame)->leaf = leaf;
+    header(frame)->n = 0;
+    header(frame)->next = 0;
+    return frame;
+}
+
+template <typename K, typename V, int PageSize>
+int PagedBPlusTree<K, V, PageSize>::treeHeight() {
+    int levels = 1;
+    Frame* cur = pool->fetch(meta.root);
+    while (!header(cur)->leaf) {
+        PageId next = asInternal(cur)->child[1];
+        pool->unpin(cur, false);
+        cur = pool->fetch(next);
+        levels++;
+    }
+    pool->unpin(cur, false);
+    return levels;
+}
+
+template <typename K, typename V, int PageSize>
+bool PagedBPlusTree<K, V, PageSize>::find(const K& x, V& value) {
+    Frame* cur = pool->fetch(meta.root);
+    while (!header(cur)->leaf) {
+        InternalPage* internal = asInternal(cur);
+        PageId next = internal->child[upperBound(internal, internal->key, x)];
+        pool->unpin(cur, false);
+        cur = pool->fetch(next);
+    }
+    LeafPage* leaf = asLeaf(cur);
+    int pos = upperBound(leaf, leaf->key, x);
+    bool found = pos > 1 && leaf->key[pos - 1] == x;
+    if (found) {
+        value = leaf->value[pos - 1];
+    }
+    pool->unpin(cur, false);
+    return found;
+}
+
+template <typename K, typename V, int PageSize>
+void PagedBPlusTree<K, V, PageSize>::insert(const K& x, const V& value) {
+    // Fail before anything is changed rather than on a full pool halfway down
+    if (pool_pages < height + 2) {
+        throw std::runtime_error("PagedBPlusTree: the tree has grown too tall for " + std::to_string(pool_pages) + " pool pages");
+    }
+    bool split_root = realInsert(x, value, meta.root);
+    if (split_root) {
+        Frame* new_root = newPage(false);
+        asInternal(new_root)->child[1] = meta.root;
+        splitChild(asInternal(new_root), 1);
+        meta.root = new_root->id;
+        pool->unpin(new_root, true);
+        height++;
+    }
+}
+
+// The page stays pinned while its child is worked on, so a path of height pages is pinned at a time
+template <typename K, typename V, int PageSize>
+bool PagedBPlusTree<K, V, PageSize>::realInsert(const K& x, const V& value, PageId id) {
+    Frame* frame = pool->fetch(id);
+    bool split;
+    if (header(frame)->leaf) {
+        LeafPage* leaf = asLeaf(frame);
+        int pos = upperBound(leaf, leaf->key, x);
+        if (pos > 1 && leaf->key[pos - 1] == x) {
+            leaf->value[pos - 1] = value;
+            pool->unpin(frame, true);
+            return false;
+        }
+        for (int i = leaf->n; i >= pos; i--) {
+            leaf->key[i + 1] = leaf->key[i];
+            leaf->value[i + 1] = leaf->value[i];
+        }
+        leaf->key[pos] = x;
+        leaf->value[pos] = value;
+        leaf->n++;
+        meta.size++;
+        split = leaf->n == LeafOrder + 1;
+    } else {
+        InternalPage* internal = asInternal(frame);
+        int pos = upperBound(internal, internal->key, x);
+        if (realInsert(x, value, internal->child[pos])) {
+            splitChild(internal, pos);
+        }
+        split = internal->n == InternalOrder;
+    }
+    pool->unpin(frame, true);
+    return split;
+}
+
+template <typename K, typename V, int PageSize>
+void PagedBPlusTree<K, V, PageSize>::splitChild(InternalPage* cur, int pos) {
+    Frame* old_frame = pool->fetch(cur->child[pos]);
+    Frame* new_frame = newPage(header(old_frame)->leaf);
+    K separator;
+
+    if (header(old_frame)->leaf) {
+        LeafPage* old_leaf = asLeaf(old_frame);
+        LeafPage* new_leaf = asLeaf(new_frame);
+        int mid = (LeafOrder + 1) / 2;
+        for (int i = mid + 1; i <= LeafOrder + 1; i++) {
+            new_leaf->key[i - mid] = old_leaf->key[i];
+            new_leaf->value[i - mid] = old_leaf->value[i];
+        }
+        new_leaf->n = LeafOrder + 1 - mid;
+        old_leaf->n = mid;
+        new_leaf->next = old_leaf->next;
+        old_leaf->next = new_frame->id;
+        separator = new_leaf->key[1];
+    } else {
+        InternalPage* old_internal = asInternal(old_frame);
+        InternalPage* new_internal = asInternal(new_frame);
+        int mid = (InternalOrder + 1) / 2;
+        for (int i = mid + 1; i <= InternalOrder; i++) {
+            new_internal->key[i - mid] = old_internal->key[i];
+        }
+        for (int i = mid + 1; i <= InternalOrder + 1; i++) {
+            new_internal->child[i - mid] = old_internal->child[i];
+        }
+        new_internal->n = InternalOrder - mid;
+        old_internal->n = mid - 1;
+        separator = old_internal->key[mid];
+    }
+
+    for (int i = cur->n; i >= pos; i--) {
+        cur->key[i + 1] = cur->key[i];
+    }
+    for (int i = cur->n + 1; i > pos; i--) {
+        cur->child[i + 1] = cur->child[i];
+    }
+    cur->n++;
+    cur->key[pos] = separator;
+    cur->child[pos + 1] = new_frame->id;
+
+    pool->unpin(old_frame, true);
+    pool->unpin(new_frame, true);
+}
+
+#endif // PAGED_BPLUS_TREE_HPP
@@ -1,6 +1,20 @@
-static const int MaxSiblings = 100000;
+#if !defined(PAIR_HEAP_HPP)
+#define PAIR_HEAP_HPP
 
-template <typename T>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <iterator>
+#include <thread>
+
+// How the subtrees are paired up after the root is removed
+enum class PairingStrategy {
+	TwoPass,			// Pair left to right, then combine right to left
+	Multipass,			// Pair repeatedly in FIFO order until one tree is left
+	AuxiliaryTwoPass	// New trees wait in an auxiliary list that is combined by multipass on pop
+};
+
+template <typename T, PairingStrategy Strategy>
 class PairHeap;
 
 template <typename T>
@@ -13,36 +27,169 @@ template <typename T>
 class PairHeapNode {
 	using PtrNode = PairHeapNode<T>*;
 	T key;
-	PtrNode first_child;
-	PtrNode next_sibling, prev;
-	PairHeapNode () = default;
-	PairHeapNode (const T& key) : first_child(nullptr), next_sibling(nullptr), prev(nullptr), key(key) {}
+	PtrNode first_child = nullptr;
+	PtrNode next_sibling = nullptr, prev = nullptr;
+	template <typename... Args>
+	explicit PairHeapNode (Args&&... args) : key(std::forward<Args>(args)...) {}
 	friend PairHeapNode* compareAndMerge<T> (PairHeapNode* first , PairHeapNode* second);
-	friend class PairHeap<T>;
+	template <typename U, PairingStrategy S>
+	friend class PairHeap;
 };
 
-template <typename T>
+template <typename T, PairingStrategy Strategy = PairingStrategy::TwoPass>
 class PairHeap {
 	using PtrNode = PairHeapNode<T>*;
 	PtrNode head = nullptr;
+	std::vector<PtrNode> siblings;	// Scratch for combining siblings
+
+	// Only used by PairingStrategy::AuxiliaryTwoPass
+	PtrNode aux_head = nullptr;
+	PtrNode aux_tail = nullptr;
+	PtrNode aux_min = nullptr;
 
 public:
-	bool empty();
+	using Handle = PtrNode;
+
+	bool empty() const;
 	PtrNode push(const T &key);
+	PtrNode push(T &&key);
+	template <typename... Args>
+	PtrNode emplace(Args&&... args);
 	PtrNode decrease(PtrNode node, const T &key);
-	T top();
-	T pop();
+	const T& top() const;
+	T pop();	// The key is moved out of the node
+	void meld(PairHeap&& other);	// Take over all the nodes of other in O(1)
+
+	template <typename Iterator>
+	static PairHeap build(Iterator first, Iterator last, int threads = std::thread::hardware_concurrency());
+
 	PairHeap (const int capacity = 0);
-	~PairHeap () = default;
-	// void clear();
+	PairHeap (const PairHeap&) = delete;
+	PairHeap (PairHeap&& other);
+	PairHeap& operator= (const PairHeap&) = delete;
+	PairHeap& operator= (PairHeap&& other);
+	~PairHeap ();
+	void clear();
 	void printHeap();
 private:
+	PtrNode insertNode(PtrNode new_node);
+	void insertAux(PtrNode node);
+	void cutNode(PtrNode node);
+	void collectSiblings(PtrNode first);
+	PtrNode twoPass();
+	PtrNode multiPass();
 	PtrNode combineSiblings(PtrNode first);
 	void printHeap(PtrNode node, int step);
 };
 
-template <typename T>
-PairHeap<T>::PairHeap (const int capacity) {}
+template <typename T, PairingStrategy Strategy>
+PairHeap<T, Strategy>::PairHeap (const int capacity) {}
+
+template <typename T, PairingStrategy Strategy>
+PairHeap<T, Strategy>::PairHeap (PairHeap&& other) {
+	meld(std::move(other));
+}
+
+template <typename T, PairingStrategy Strategy>
+PairHeap<T, Strategy>& PairHeap<T, Strategy>::operator= (PairHeap&& other) {
+	if (this != &other) {
+		clear();
+		meld(std::move(other));
+	}
+	return *this;
+}
+
+template <typename T, PairingStrategy Strategy>
+PairHeap<T, Strategy>::~PairHeap () {
+	clear();
+}
+
+template <typename T, PairingStrategy Strategy>
+void PairHeap<T, Strategy>::clear() {
+	// Trees can be very deep, so use the scratch buffer as an explicit stack
+	siblings.clear();
+	if (head) {
+		siblings.push_back(head);
+	}
+	if (aux_head) {
+		siblings.push_back(aux_head);
+	}
+	while (!siblings.empty()) {
+		PtrNode node = siblings.back();
+		siblings.pop_back();
+		if (node->first_child) {
+			siblings.push_back(node->first_child);
+		}
+		if (node->next_sibling) {
+			siblings.push_back(node->next_sibling);
+		}
+		delete node;
+	}
+	head = aux_head = aux_tail = aux_min = nullptr;
+}
+
+template <typename T, PairingStrategy Strategy>
+void PairHeap<T, Strategy>::meld(PairHeap&& other) {
+	if (this == &other) {
+		return;
+	}
+	if (other.head) {
+		if (Strategy == PairingStrategy::AuxiliaryTwoPass) {
+			insertAux(other.head);
+		} else {
+			head = head ? compareAndMerge(head, other.head) : other.head;
+		}
+	}
+	if (other.aux_head) {
+		// Append the auxiliary list of other to ours
+		if (aux_head) {
+			aux_tail->next_sibling = other.aux_head;
+			other.aux_head->prev = aux_tail;
+		} else {
+			aux_head = other.aux_head;
+		}
+		aux_tail = other.aux_tail;
+		if (aux_min == nullptr || other.aux_min->key < aux_min->key) {
+			aux_min = other.aux_min;
+		}
+	}
+	other.head = other.aux_head = other.aux_tail = other.aux_min = nullptr;
+}
+
+// Build sub-heaps from slices of [first, last) on several threads, then meld them pairwise
+template <typename T, PairingStrategy Strategy>
+template <typename Iterator>
+PairHeap<T, Strategy> PairHeap<T, Strategy>::build(Iterator first, Iterator last, int threads) {
+	long long count = std::distance(first, last);
+	if (threads > count) {
+		threads = count;
+	}
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	std::vector<PairHeap> parts(threads);
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++) {
+		Iterator slice_end = std::next(first, count / threads + (i < count % threads));
+		workers.emplace_back([&parts, i, first, slice_end]() {
+			for (Iterator itr = first; itr != slice_end; ++itr) {
+				parts[i].push(*itr);
+			}
+		});
+		first = slice_end;
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	for (int stride = 1; stride < threads; stride *= 2) {
+		for (int i = 0; i + stride < threads; i += 2 * stride) {
+			parts[i].meld(std::move(parts[i + stride]));
+		}
+	}
+	return std::move(parts[0]);
+}
 
 // F is guaranteed to have no sibling
 template <typename T>
@@ -74,12 +221,28 @@ PairHeapNode<T>* compareAndMerge (PairHeapNode<T>* F, PairHeapNode<T>* S) {
 	}
 }
 
-template <typename T>
-PairHeapNode<T>* PairHeap<T>::push(const T& key) {
-	PtrNode new_node;
-	new_node = new PairHeapNode<T>(key);
+template <typename T, PairingStrategy Strategy>
+PairHeapNode<T>* PairHeap<T, Strategy>::push(const T& key) {
+	return insertNode(new PairHeapNode<T>(key));
+}
+
+template <typename T, PairingStrategy Strategy>
+PairHeapNode<T>* PairHeap<T, Strategy>::push(T&& key) {
+	return insertNode(new PairHeapNode<T>(std::move(key)));
+}
 
-	if (head == nullptr) {
+// Construct the key in place inside the new node
+template <typename T, PairingStrategy Strategy>
+template <typename... Args>
+PairHeapNode<T>* PairHeap<T, Strategy>::emplace(Args&&... args) {
+	return insertNode(new PairHeapNode<T>(std::forward<Args>(args)...));
+}
+
+template <typename T, PairingStrategy Strategy>
+PairHeapNode<T>* PairHeap<T, Strategy>::insertNode(PtrNode new_node) {
+	if (Strategy == PairingStrategy::AuxiliaryTwoPass) {
+		insertAux(new_node);
+	} else if (head == nullptr) {
 		head = new_node;
 	} else {
 		head = compareAndMerge(head, new_node);
@@ -87,41 +250,81 @@ PairHeapNode<T>* PairHeap<T>::push(const T& key) {
 	return new_node;
 }
 
-template <typename T>
-PairHeapNode<T>* PairHeap<T>::decrease(PtrNode node, const T& key) {
-	node->key = key;
-	if (head == node) {
-		return node;
+// Put a tree in front of the auxiliary list
+template <typename T, PairingStrategy Strategy>
+void PairHeap<T, Strategy>::insertAux(PtrNode node) {
+	node->prev = nullptr;
+	node->next_sibling = aux_head;
+	if (aux_head) {
+		aux_head->prev = node;
+	} else {
+		aux_tail = node;
+	}
+	aux_head = node;
+	if (aux_min == nullptr || node->key < aux_min->key) {
+		aux_min = node;
 	}
-	// cut the node from the heap
+}
+
+// Cut the subtree of node out of wherever it is, node must not be the head
+template <typename T, PairingStrategy Strategy>
+void PairHeap<T, Strategy>::cutNode(PtrNode node) {
 	if (node->next_sibling) {
 		node->next_sibling->prev = node->prev;
+	} else if (node == aux_tail) {
+		aux_tail = node->prev;
 	}
-	// Notice that node->prev is guaranteed to exist since it is not the root
-	if (node->prev->first_child == node) {	// node is the first child
+	if (node->prev == nullptr) {	// node is the first in the auxiliary list
+		aux_head = node->next_sibling;
+	} else if (node->prev->first_child == node) {	// node is the first child
 		node->prev->first_child = node->next_sibling;
 	} else {	// node has a left sibling
 		node->prev->next_sibling = node->next_sibling;
 	}
 	node->next_sibling = nullptr;
-	head = compareAndMerge (head, node);
+	node->prev = nullptr;
+}
+
+template <typename T, PairingStrategy Strategy>
+PairHeapNode<T>* PairHeap<T, Strategy>::decrease(PtrNode node, const T& key) {
+	node->key = key;
+	if (head == node) {
+		return node;
+	}
+	cutNode(node);
+	if (Strategy == PairingStrategy::AuxiliaryTwoPass) {
+		insertAux(node);
+	} else {
+		head = compareAndMerge (head, node);
+	}
 	return node;
 }
 
-template <typename T>
-T PairHeap<T>::top() {
+template <typename T, PairingStrategy Strategy>
+const T& PairHeap<T, Strategy>::top() const {
+	if (aux_min != nullptr && (head == nullptr || aux_min->key < head->key)) {
+		return aux_min->key;
+	}
 	return head->key;
 }
 
-template <typename T>
-bool PairHeap<T>::empty() {
-	return head == nullptr;
+template <typename T, PairingStrategy Strategy>
+bool PairHeap<T, Strategy>::empty() const {
+	return head == nullptr && aux_head == nullptr;
 }
 
-template <typename T>
-T PairHeap<T>::pop() {
+template <typename T, PairingStrategy Strategy>
+T PairHeap<T, Strategy>::pop() {
 	// Did not check underflow
-	T ret = head->key;
+	if (aux_head != nullptr) {
+		// Combine the auxiliary trees into one and merge it with the main tree
+		collectSiblings(aux_head);
+		PtrNode aux_tree = multiPass();
+		head = head ? compareAndMerge(head, aux_tree) : aux_tree;
+		aux_head = aux_tail = aux_min = nullptr;
+	}
+
+	T ret = std::move(head->key);
 	if (head->first_child != nullptr) {
 		auto new_head = combineSiblings(head->first_child);
 		delete head;
@@ -133,48 +336,74 @@ T PairHeap<T>::pop() {
 	return ret;
 }
 
-// combine siblings of first, return what results
-template <typename T>
-PairHeapNode<T>* PairHeap<T>::combineSiblings (PtrNode first) {
-	static PtrNode Array[MaxSiblings];
-	if (first->next_sibling == nullptr) { // only one sibling
-		return first;
-	}
-
-	// Put all siblings in the array
-	int cnt_siblings = 0;
-	while (first != nullptr) {
-		Array[cnt_siblings++] = first;
-		first->prev->next_sibling = nullptr;	// break the link
-		first = first->next_sibling;
+// Move the siblings starting from first into the scratch buffer, unlinked
+template <typename T, PairingStrategy Strategy>
+void PairHeap<T, Strategy>::collectSiblings(PtrNode first) {
+	siblings.clear();
+	for (PtrNode itr = first, nxt; itr != nullptr; itr = nxt) {
+		nxt = itr->next_sibling;
+		itr->next_sibling = nullptr;	// break the link
+		itr->prev = nullptr;
+		siblings.push_back(itr);
 	}
+}
 
-	// Combine them from left to right and then back
+// Combine the buffered trees from left to right and then back
+template <typename T, PairingStrategy Strategy>
+PairHeapNode<T>* PairHeap<T, Strategy>::twoPass() {
+	int cnt_siblings = siblings.size();
 	int pos;
 	for (pos = 0; pos + 1 < cnt_siblings; pos += 2) {
-		Array[pos] = compareAndMerge(Array[pos], Array[pos + 1]);
+		siblings[pos] = compareAndMerge(siblings[pos], siblings[pos + 1]);
 	}
 
 	pos -= 2;
 	if (pos == cnt_siblings - 3) { // there is one left in the first pass
-		Array[pos] = compareAndMerge (Array[pos], Array[pos + 2]);
+		siblings[pos] = compareAndMerge (siblings[pos], siblings[pos + 2]);
 	}
 
-	while (pos) {
-		Array[pos - 2] = compareAndMerge(Array[pos - 2], Array[pos]);
+	while (pos > 0) {
+		siblings[pos - 2] = compareAndMerge(siblings[pos - 2], siblings[pos]);
 		pos -= 2;
 	}
-	return Array[0];
+	return siblings[0];
 }
 
-template <typename T>
-void PairHeap<T>::printHeap () {
+// Combine the buffered trees pairwise, appending each result to the back, until one is left
+template <typename T, PairingStrategy Strategy>
+PairHeapNode<T>* PairHeap<T, Strategy>::multiPass() {
+	for (size_t front = 0; front + 1 < siblings.size(); front += 2) {
+		siblings.push_back(compareAndMerge(siblings[front], siblings[front + 1]));
+	}
+	return siblings.back();
+}
+
+// combine siblings of first, return what results
+template <typename T, PairingStrategy Strategy>
+PairHeapNode<T>* PairHeap<T, Strategy>::combineSiblings (PtrNode first) {
+	if (first->next_sibling == nullptr) { // only one sibling
+		first->prev = nullptr;
+		return first;
+	}
+	collectSiblings(first);
+	if (Strategy == PairingStrategy::Multipass) {
+		return multiPass();
+	} else {
+		return twoPass();
+	}
+}
+
+template <typename T, PairingStrategy Strategy>
+void PairHeap<T, Strategy>::printHeap () {
 	std::cout << "===================" << std::endl;
 	printHeap(head, 2);
+	for (auto itr = aux_head; itr != nullptr; itr = itr->next_sibling) {
+		printHeap(itr, 2);
+	}
 }
 
-template <typename T>
-void PairHeap<T>::printHeap(PtrNode node, int step) {
+template <typename T, PairingStrategy Strategy>
+void PairHeap<T, Strategy>::printHeap(PtrNode node, int step) {
 	if (node == nullptr) {
 		return;
 	}
@@ -189,4 +418,6 @@ void PairHeap<T>::printHeap(PtrNode node, int step) {
 	for (auto itr = node->first_child; itr != nullptr; itr = itr->next_sibling) {
 		printHeap(itr, step + 2);
 	}
-}
\ No newline at end of file
+}
+
+#endif // PAIR_HEAP_HPP
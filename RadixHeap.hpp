@@ -0,0 +1,203 @@
+#if !defined(RADIX_HEAP_HPP)
+#define RADIX_HEAP_HPP
+
+#include "PairHeap.hpp"
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Monotone priority queue for unsigned integral keys, e.g. Dijkstra with integer distances.
+// Bucket i > 0 holds the keys whose highest bit differing from `last` is bit i - 1,
+// bucket 0 holds the keys equal to last.
+// Keys given to push() or decrease() must not be smaller than the last key returned by top() or pop().
+template <typename K>
+class RadixHeap {
+	static_assert(std::is_integral<K>::value && std::is_unsigned<K>::value && !std::is_same<K, bool>::value, "RadixHeap needs unsigned integral keys");
+public:
+	using Handle = uint32_t;
+
+	bool empty() const;
+	int getSize() const;
+	Handle push(const K &key);
+	Handle decrease(Handle handle, const K &key);
+	const K& top() const;
+	K pop();
+	void clear();
+	RadixHeap (const int capacity = 0);
+
+private:
+	static const int Buckets = std::numeric_limits<K>::digits + 1;
+
+	// top() spreads a bucket out to find the minimum, which only regroups the keys
+	mutable std::vector<Handle> bucket[Buckets];
+	std::vector<K> keys;				// Indexed by handle
+	mutable std::vector<uint8_t> bucket_of;		// Indexed by handle
+	mutable std::vector<uint32_t> slot_of;		// Position inside the bucket, indexed by handle
+	std::vector<Handle> free_handles;
+	mutable K last = 0;
+	int size = 0;
+
+	int bucketIndex(K key) const;
+	void place(Handle handle) const;
+	void unplace(Handle handle);
+	void refill() const;	// Make sure bucket 0 is not empty
+};
+
+// Implementation below
+
+template <typename K>
+RadixHeap<K>::RadixHeap (const int capacity) {
+	keys.reserve(capacity);
+	bucket_of.reserve(capacity);
+	slot_of.reserve(capacity);
+}
+
+template <typename K>
+void RadixHeap<K>::clear() {
+	for (auto& b : bucket) {
+		b.clear();
+	}
+	keys.clear();
+	bucket_of.clear();
+	slot_of.clear();
+	free_handles.clear();
+	last = 0;
+	size = 0;
+}
+
+template <typename K>
+bool RadixHeap<K>::empty() const {
+	return size == 0;
+}
+
+template <typename K>
+int RadixHeap<K>::getSize() const {
+	return size;
+}
+
+template <typename K>
+int RadixHeap<K>::bucketIndex(K key) const {
+	K diff = key ^ last;
+	if (diff == 0) {
+		return 0;
+	}
+#if defined(__GNUC__)
+	return 64 - __builtin_clzll(static_cast<unsigned long long>(diff));
+#else
+	int width = 0;
+	for (; diff; diff >>= 1) {
+		width++;
+	}
+	return width;
+#endif
+}
+
+template <typename K>
+void RadixHeap<K>::place(Handle handle) const {
+	int b = bucketIndex(keys[handle]);
+	bucket_of[handle] = b;
+	slot_of[handle] = bucket[b].size();
+	bucket[b].push_back(handle);
+}
+
+// Take handle out of its bucket by moving the last one of the bucket into its slot
+template <typename K>
+void RadixHeap<K>::unplace(Handle handle) {
+	std::vector<Handle>& b = bucket[bucket_of[handle]];
+	Handle moved = b.back();
+	b[slot_of[handle]] = moved;
+	slot_of[moved] = slot_of[handle];
+	b.pop_back();
+}
+
+template <typename K>
+typename RadixHeap<K>::Handle RadixHeap<K>::push(const K& key) {
+	Handle handle;
+	if (!free_handles.empty()) {
+		handle = free_handles.back();
+		free_handles.pop_back();
+		keys[handle] = key;
+	} else {
+		handle = keys.size();
+		keys.push_back(key);
+		bucket_of.push_back(0);
+		slot_of.push_back(0);
+	}
+	place(handle);
+	size++;
+	return handle;
+}
+
+template <typename K>
+typename RadixHeap<K>::Handle RadixHeap<K>::decrease(Handle handle, const K& key) {
+	keys[handle] = key;
+	if (bucketIndex(key) != bucket_of[handle]) {
+		unplace(handle);
+		place(handle);
+	}
+	return handle;
+}
+
+// Move the smallest key of the first non-empty bucket into last and spread that bucket out.
+// Every key of the bucket lands in a lower one.
+template <typename K>
+void RadixHeap<K>::refill() const {
+	if (!bucket[0].empty()) {
+		return;
+	}
+	int b = 1;
+	while (bucket[b].empty()) {
+		b++;
+	}
+	K min_key = keys[bucket[b][0]];
+	for (Handle handle : bucket[b]) {
+		if (keys[handle] < min_key) {
+			min_key = keys[handle];
+		}
+	}
+	last = min_key;
+	std::vector<Handle> spread;
+	spread.swap(bucket[b]);
+	for (Handle handle : spread) {
+		place(handle);
+	}
+	spread.clear();
+	spread.swap(bucket[b]);	// Keep the capacity around
+}
+
+template <typename K>
+const K& RadixHeap<K>::top() const {
+	// Did not check underflow!
+	refill();
+	return last;
+}
+
+template <typename K>
+K RadixHeap<K>::pop() {
+	// Did not check underflow!
+	refill();
+	Handle handle = bucket[0].back();
+	bucket[0].pop_back();
+	free_handles.push_back(handle);
+	size--;
+	return last;
+}
+
+// Picks the priority queue for T: RadixHeap when T is an unsigned integer and the caller
+// declares monotone use (keys never go below the last popped one), PairHeap otherwise.
+template <typename T, bool Monotone = false, typename Enable = void>
+struct PriorityQueueFor {
+	using type = PairHeap<T>;
+};
+
+template <typename T>
+struct PriorityQueueFor<T, true, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value
+	&& !std::is_same<T, bool>::value>::type> {
+	using type = RadixHeap<T>;
+};
+
+template <typename T, bool Monotone = false>
+using PriorityQueue = typename PriorityQueueFor<T, Monotone>::type;
+
+#endif // RADIX_HEAP_HPP
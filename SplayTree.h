@@ -2,6 +2,7 @@
 #define SPLAYTREE_H
 
 #include <iostream>
+#include <utility>
 #define SPLAY_DEBUG
 #define SPLAY_PORTABLE
 
@@ -14,6 +15,7 @@ public:
     using PtrSplayNode = SplayTreeNode<T>*;
     SplayTreeNode();
     SplayTreeNode(const T& key);
+    SplayTreeNode(T&& key);
     ~SplayTreeNode();
 
     T getKey();
@@ -58,6 +60,18 @@ SplayTreeNode<T>::SplayTreeNode(const T& key) :
 #endif
     {}
 
+template <typename T>
+SplayTreeNode<T>::SplayTreeNode(T&& key) :
+    key(std::move(key)),
+    left(nullptr),
+    right(nullptr),
+    parent(nullptr)
+#ifndef SPLAY_PORTABLE
+    ,size(1),
+    count(1)
+#endif
+    {}
+
 template <typename T>
 SplayTreeNode<T>::~SplayTreeNode() {}
 
@@ -151,6 +165,9 @@ public:
     ~SplayTree();
 
     void insert(const T& x);
+    void insert(T&& x);
+    template <typename... Args>
+    void emplace(Args&&... args);
     void remove(const T& x);
     PtrSplayNode find(const T& x);
     PtrSplayNode predecessor(PtrSplayNode node);
@@ -170,6 +187,8 @@ public:
 private:
     PtrSplayNode root;
 
+    template <typename U>
+    void insertKey(U&& x);
     void splay(PtrSplayNode node);
     void deleteSubtree(PtrSplayNode node);
 
@@ -203,8 +222,26 @@ void SplayTree<T>::deleteSubtree(PtrSplayNode node) {
 
 template <typename T>
 void SplayTree<T>::insert(const T& x) {
+    insertKey(x);
+}
+
+template <typename T>
+void SplayTree<T>::insert(T&& x) {
+    insertKey(std::move(x));
+}
+
+template <typename T>
+template <typename... Args>
+void SplayTree<T>::emplace(Args&&... args) {
+    insertKey(T(std::forward<Args>(args)...));
+}
+
+// The key is only copied or moved into a node when a new node is created
+template <typename T>
+template <typename U>
+void SplayTree<T>::insertKey(U&& x) {
     if (root == nullptr) {
-        root = new SplayTreeNode<T>(x);
+        root = new SplayTreeNode<T>(std::forward<U>(x));
         return;
     }
     PtrSplayNode cur = root, new_node;
@@ -213,7 +250,7 @@ void SplayTree<T>::insert(const T& x) {
             if (cur->right != nullptr) {
                 cur = cur->right;
             } else {
-                cur->right = new SplayTreeNode<T>(x);
+                cur->right = new SplayTreeNode<T>(std::forward<U>(x));
                 new_node = cur->right;
                 new_node->parent = cur;
 #ifndef SPLAY_PORTABLE
@@ -225,7 +262,7 @@ void SplayTree<T>::insert(const T& x) {
             if (cur->left != nullptr) {
                 cur = cur->left;
             } else {
-                cur->left = new SplayTreeNode<T>(x);
+                cur->left = new SplayTreeNode<T>(std::forward<U>(x));
                 new_node = cur->left;
                 new_node->parent = cur;
 #ifndef SPLAY_PORTABLE
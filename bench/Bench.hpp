@@ -0,0 +1,43 @@
+#if !defined(BENCH_HPP)
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Shared by the drivers in bench/. Each driver is one file with its own main, built from this
+// directory with
+//     g++ -std=c++17 -O2 -march=native -I.. <driver>.cpp -o <driver>
+// (plus -pthread for the threaded ones). Inputs come from fixed seeds, so two runs do the same
+// work; sizes are optional command line arguments. Every driver prints a checksum of its
+// results, which should match between runs and between the structures it compares.
+
+// Wall clock seconds since construction or the last reset()
+class Timer {
+public:
+    Timer() { reset(); }
+    void reset() { start = std::chrono::steady_clock::now(); }
+    double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// argv[index] as a number, fallback if it is not given
+inline long argOr(int argc, char** argv, int index, long fallback) {
+    return index < argc ? std::atol(argv[index]) : fallback;
+}
+
+// count keys in [0, range) from a generator seeded with seed, range 0 means the full range of K
+template <typename K>
+std::vector<K> randomKeys(size_t count, uint64_t range, unsigned seed) {
+    std::mt19937_64 gen(seed);
+    std::vector<K> keys(count);
+    for (K& key : keys) {
+        key = static_cast<K>(range ? gen() % range : gen());
+    }
+    return keys;
+}
+
+#endif // BENCH_HPP
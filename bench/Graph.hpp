@@ -0,0 +1,106 @@
+#if !defined(BENCH_GRAPH_HPP)
+#define BENCH_GRAPH_HPP
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Directed graph in compressed rows: the edges of u are edge[first[u] .. first[u + 1])
+struct Graph {
+    struct Edge {
+        uint32_t to;
+        uint32_t weight;
+    };
+    std::vector<uint32_t> first;
+    std::vector<Edge> edge;
+
+    int vertices() const { return first.size() - 1; }
+};
+
+// degree edges out of each vertex to random vertices, weights in [0, max_weight)
+inline Graph randomGraph(int vertices, int degree, uint32_t max_weight, unsigned seed) {
+    std::mt19937 gen(seed);
+    Graph g;
+    g.first.resize(vertices + 1);
+    g.edge.resize(static_cast<size_t>(vertices) * degree);
+    for (int u = 0; u <= vertices; u++) {
+        g.first[u] = static_cast<uint32_t>(u) * degree;
+    }
+    for (Graph::Edge& e : g.edge) {
+        e.to = gen() % vertices;
+        e.weight = gen() % max_weight;
+    }
+    return g;
+}
+
+// width x width grid, each cell linked both ways to its right and lower neighbours
+inline Graph gridGraph(int width, uint32_t max_weight, unsigned seed) {
+    std::mt19937 gen(seed);
+    int vertices = width * width;
+    std::vector<std::vector<Graph::Edge>> out(vertices);
+    for (int u = 0; u < vertices; u++) {
+        if (u % width + 1 < width) {
+            uint32_t w = gen() % max_weight;
+            out[u].push_back({static_cast<uint32_t>(u + 1), w});
+            out[u + 1].push_back({static_cast<uint32_t>(u), w});
+        }
+        if (u + width < vertices) {
+            uint32_t w = gen() % max_weight;
+            out[u].push_back({static_cast<uint32_t>(u + width), w});
+            out[u + width].push_back({static_cast<uint32_t>(u), w});
+        }
+    }
+    Graph g;
+    g.first.push_back(0);
+    for (auto& edges : out) {
+        g.edge.insert(g.edge.end(), edges.begin(), edges.end());
+        g.first.push_back(g.edge.size());
+    }
+    return g;
+}
+
+// Dijkstra from vertex 0 with decrease-key, on any heap with push (returning a handle), decrease,
+// pop and empty. Keys pack (distance << 32 | vertex), so they are plain unsigned integers that
+// every heap orders the same way. Returns the sum of the finite distances.
+template <typename Heap>
+uint64_t dijkstra(const Graph& g) {
+    using Handle = decltype(std::declval<Heap&>().push(uint64_t()));
+    const uint64_t unreached = ~uint64_t(0);
+    int n = g.vertices();
+    std::vector<uint64_t> dist(n, unreached);
+    std::vector<Handle> handle(n);
+    std::vector<char> state(n, 0);     // 0 unseen, 1 in the heap, 2 done
+    Heap heap;
+    dist[0] = 0;
+    handle[0] = heap.push(0);
+    state[0] = 1;
+    while (!heap.empty()) {
+        uint64_t top = heap.pop();
+        uint32_t u = static_cast<uint32_t>(top);
+        state[u] = 2;
+        for (uint32_t i = g.first[u]; i < g.first[u + 1]; i++) {
+            const Graph::Edge& e = g.edge[i];
+            uint64_t d = dist[u] + e.weight;
+            if (state[e.to] == 2 || d >= dist[e.to]) {
+                continue;
+            }
+            dist[e.to] = d;
+            if (state[e.to] == 1) {
+                heap.decrease(handle[e.to], d << 32 | e.to);
+            } else {
+                handle[e.to] = heap.push(d << 32 | e.to);
+                state[e.to] = 1;
+            }
+        }
+    }
+    uint64_t sum = 0;
+    for (uint64_t d : dist) {
+        if (d != unreached) {
+            sum += d;
+        }
+    }
+    return sum;
+}
+
+#endif // BENCH_GRAPH_HPP
@@ -0,0 +1,61 @@
+// BinomialQueue against std::priority_queue: N inserts, then N Top() + DeleteMin(), then a mixed
+// phase of one insert and one DeleteMin per step on the half-full queue. Needs -pthread, as
+// BinomialQueue.hpp uses std::thread for MeldAll.
+//     ./binomial_queue [keys = 5000000]
+#include "Bench.hpp"
+#include "BinomialQueue.hpp"
+#include <cstdio>
+#include <functional>
+#include <queue>
+
+struct Times {
+    double load, drain, mixed;
+    long long check;
+};
+
+template <typename Queue, typename Push, typename Pop>
+Times run(const std::vector<int>& keys, Push push, Pop pop) {
+    Times times;
+    Queue queue;
+    times.check = 0;
+    Timer timer;
+    for (int key : keys) {
+        push(queue, key);
+    }
+    times.load = timer.seconds();
+    timer.reset();
+    for (size_t i = 0; i < keys.size(); i++) {
+        times.check += pop(queue);
+    }
+    times.drain = timer.seconds();
+    for (size_t i = 0; i < keys.size() / 2; i++) {
+        push(queue, keys[i]);
+    }
+    timer.reset();
+    for (size_t i = keys.size() / 2; i < keys.size(); i++) {
+        push(queue, keys[i]);
+        times.check += pop(queue);
+    }
+    times.mixed = timer.seconds();
+    return times;
+}
+
+void print(const char* name, const Times& times) {
+    printf("%-20s load %.3f s  drain %.3f s  mixed %.3f s  check %lld\n", name, times.load, times.drain, times.mixed, times.check);
+}
+
+int main(int argc, char** argv) {
+    long count = argOr(argc, argv, 1, 5000000);
+    std::vector<int> keys = randomKeys<int>(count, 0, 13);
+
+    printf("keys %ld\n", count);
+    using StdQueue = std::priority_queue<int, std::vector<int>, std::greater<int>>;
+    for (int round = 0; round < 2; round++) {
+        print("BinomialQueue", run<BinomialQueue<int>>(keys,
+            [](BinomialQueue<int>& q, int key) { q.Insert(key); },
+            [](BinomialQueue<int>& q) { int top = q.Top(); q.DeleteMin(); return top; }));
+        print("std::priority_queue", run<StdQueue>(keys,
+            [](StdQueue& q, int key) { q.push(key); },
+            [](StdQueue& q) { int top = q.top(); q.pop(); return top; }));
+    }
+}
@@ -0,0 +1,65 @@
+// Insert/erase churn on BPlusTree, printing the node count and bytes as it goes:
+// - random: each op erases a random live key and inserts a new random key
+// - window: each op inserts key i and erases key i - live, a sliding window of live keys
+//     ./bplus_tree_churn [live keys = 1000000] [ops = 20000000]
+#include "Bench.hpp"
+#include "BPlusTree.hpp"
+#include <cstdio>
+#include <random>
+
+using Tree = BPlusTree<int, int, 64>;
+
+void report(const Tree& tree, long op, long live, const Timer& timer) {
+    printf("  %9ld ops  %7zu nodes  %7.2f MB  %5.1f B/key  %6.2f s\n", op, tree.getNodeCount(),
+        tree.getBytes() / 1e6, static_cast<double>(tree.getBytes()) / live, timer.seconds());
+}
+
+int main(int argc, char** argv) {
+    long live = argOr(argc, argv, 1, 1000000);
+    long ops = argOr(argc, argv, 2, 20000000);
+    long every = ops / 10;
+
+    printf("random churn, %ld live keys\n", live);
+    {
+        Tree tree;
+        std::mt19937 gen(19);
+        std::vector<int> keys;
+        while (static_cast<long>(keys.size()) < live) {
+            int key = gen() & 0x3fffffff;
+            if (tree.find(key) == nullptr) {
+                tree.insert(key, 0);
+                keys.push_back(key);
+            }
+        }
+        Timer timer;
+        report(tree, 0, live, timer);
+        for (long op = 1; op <= ops; op++) {
+            int& slot = keys[gen() % live];
+            tree.erase(slot);
+            do {
+                slot = gen() & 0x3fffffff;
+            } while (tree.find(slot) != nullptr);
+            tree.insert(slot, op);
+            if (op % every == 0) {
+                report(tree, op, live, timer);
+            }
+        }
+    }
+
+    printf("sliding window, %ld live keys\n", live);
+    {
+        Tree tree;
+        for (long i = 0; i < live; i++) {
+            tree.insert(i, i);
+        }
+        Timer timer;
+        report(tree, 0, live, timer);
+        for (long op = 1; op <= ops; op++) {
+            tree.insert(live + op - 1, op);
+            tree.erase(op - 1);
+            if (op % every == 0) {
+                report(tree, op, live, timer);
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+// BPlusTree::findBatch against a loop of find() on trees larger than the last level cache.
+// Random int keys are bulk loaded at fill 0.7, then the same probes (half of them present) are
+// looked up in batches; each timing is the best of 3 passes.
+//     ./bplus_tree_find_batch [keys = 10000000] [probes = 4000000] [batch = 4096]
+#include "Bench.hpp"
+#include "BPlusTree.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+// Million lookups per second over all probes, best of 3; check sums the values found
+template <typename Lookup>
+double best(const std::vector<int>& probes, int batch, Lookup lookup, long& check) {
+    std::vector<int*> results(batch);
+    double fastest = 1e30;
+    for (int pass = 0; pass < 3; pass++) {
+        long sum = 0;
+        Timer timer;
+        for (size_t first = 0; first < probes.size(); first += batch) {
+            int count = std::min<size_t>(batch, probes.size() - first);
+            lookup(probes.data() + first, count, results.data());
+            for (int i = 0; i < count; i++) {
+                sum += results[i] ? *results[i] : 0;
+            }
+        }
+        fastest = std::min(fastest, timer.seconds());
+        check = sum;
+    }
+    return probes.size() / fastest / 1e6;
+}
+
+template <int Order>
+void run(const std::vector<std::pair<int, int>>& pairs, const std::vector<int>& probes, int batch) {
+    BPlusTree<int, int, Order> tree;
+    tree.bulkLoad(pairs.begin(), pairs.end(), 0.7);
+    long find_check = 0, batch_check = 0;
+    double single = best(probes, batch, [&](const int* keys, int count, int** results) {
+        for (int i = 0; i < count; i++) {
+            results[i] = tree.find(keys[i]);
+        }
+    }, find_check);
+    double batched = best(probes, batch, [&](const int* keys, int count, int** results) {
+        tree.findBatch(keys, count, results);
+    }, batch_check);
+    printf("%5d   %7.0f MB   %6.2f M/s   %6.2f M/s (%.1fx)   check %ld %ld\n", Order, tree.getBytes() / 1e6,
+        single, batched, batched / single, find_check, batch_check);
+}
+
+int main(int argc, char** argv) {
+    long count = argOr(argc, argv, 1, 10000000);
+    long probe_count = argOr(argc, argv, 2, 4000000);
+    int batch = argOr(argc, argv, 3, 4096);
+
+    // Even keys go in, probes are drawn over twice the range so half of them are present
+    std::vector<int> keys = randomKeys<int>(count, 1u << 30, 22);
+    for (int& key : keys) {
+        key &= ~1;
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::vector<std::pair<int, int>> pairs;
+    for (int key : keys) {
+        pairs.emplace_back(key, key >> 1);
+    }
+    std::vector<int> probes(probe_count);
+    std::vector<uint64_t> draws = randomKeys<uint64_t>(probe_count, 0, 23);
+    for (long i = 0; i < probe_count; i++) {
+        probes[i] = draws[i] % 2 ? keys[draws[i] / 2 % keys.size()] : keys[draws[i] / 2 % keys.size()] + 1;
+    }
+
+    printf("keys %zu, probes %ld, batch %d\n", keys.size(), probe_count, batch);
+    printf("Order   tree          find         findBatch\n");
+    run<16>(pairs, probes, batch);
+    run<64>(pairs, probes, batch);
+    run<128>(pairs, probes, batch);
+}
@@ -0,0 +1,54 @@
+// Point lookups in BPlusTree at several Orders. int keys take the SSE/AVX node search when
+// -march enables it; the same keys wrapped in a struct take the generic branchless binary search.
+// The driver only uses insert and find, so it also builds against the BPlusTree.hpp with the old
+// linear loop (git show 09a22b0^:BPlusTree.hpp).
+//     ./bplus_tree_search [keys = 1048576] [lookups = 4000000]
+#include "Bench.hpp"
+#include "BPlusTree.hpp"
+#include <cstdio>
+
+// An int that BPlusSearch has no specialization for
+struct Wrapped {
+    int value;
+    bool operator<(const Wrapped& other) const { return value < other.value; }
+    bool operator>(const Wrapped& other) const { return value > other.value; }
+    bool operator==(const Wrapped& other) const { return value == other.value; }
+};
+
+// Million lookups per second; hits counts the keys found
+template <typename K, int Order>
+double run(const std::vector<int>& keys, const std::vector<int>& lookups, long& hits) {
+    BPlusTree<K, int, Order> tree;
+    for (size_t i = 0; i < keys.size(); i++) {
+        tree.insert(K{keys[i]}, i);
+    }
+    Timer timer;
+    for (int x : lookups) {
+        hits += tree.find(K{x}) != nullptr;
+    }
+    return lookups.size() / timer.seconds() / 1e6;
+}
+
+template <int Order>
+void compare(const std::vector<int>& keys, const std::vector<int>& lookups) {
+    long hits = 0;
+    double simd = run<int, Order>(keys, lookups, hits);
+    double generic = run<Wrapped, Order>(keys, lookups, hits);
+    printf("%5d   %8.2f   %8.2f   hits %ld\n", Order, simd, generic, hits);
+}
+
+int main(int argc, char** argv) {
+    long count = argOr(argc, argv, 1, 1 << 20);
+    long lookup_count = argOr(argc, argv, 2, 4000000);
+    std::vector<int> keys = randomKeys<int>(count, 4 * count, 17);
+    std::vector<int> lookups = randomKeys<int>(lookup_count, 4 * count, 18);
+
+    printf("keys %ld, lookups %ld, M lookups/s\n", count, lookup_count);
+    printf("Order        int    wrapped\n");
+    compare<8>(keys, lookups);
+    compare<16>(keys, lookups);
+    compare<32>(keys, lookups);
+    compare<64>(keys, lookups);
+    compare<128>(keys, lookups);
+    compare<256>(keys, lookups);
+}
@@ -0,0 +1,45 @@
+// Random inserts and lookups on BufferedBPlusTree against BPlusTree, then erases of every key to
+// show the memory the buffered tree gives back.
+//     ./buffered_bplus_tree [keys = 5000000]
+#include "Bench.hpp"
+#include "BPlusTree.hpp"
+#include "BufferedBPlusTree.hpp"
+#include <cstdio>
+
+template <typename Tree>
+void run(const char* name, const std::vector<int>& keys) {
+    Tree tree;
+    Timer timer;
+    for (size_t i = 0; i < keys.size(); i++) {
+        tree.insert(keys[i], i);
+    }
+    double insert = timer.seconds();
+    size_t bytes = tree.getBytes();
+
+    long check = 0;
+    timer.reset();
+    for (int key : keys) {
+        long* value = tree.find(key);
+        check += value ? *value : -1;
+    }
+    double find = timer.seconds();
+
+    timer.reset();
+    for (int key : keys) {
+        tree.erase(key);
+    }
+    double erase = timer.seconds();
+    printf("%-26s insert %6.2f s  find %6.2f s  erase %6.2f s  %7.1f MB, %5.2f MB after erase  check %ld\n", name,
+        insert, find, erase, bytes / 1e6, tree.getBytes() / 1e6, check);
+}
+
+int main(int argc, char** argv) {
+    long count = argOr(argc, argv, 1, 5000000);
+    std::vector<int> keys = randomKeys<int>(count, 0, 24);
+
+    printf("keys %ld\n", count);
+    run<BPlusTree<int, long, 64>>("BPlusTree<64>", keys);
+    run<BufferedBPlusTree<int, long, 64, 256>>("BufferedBPlusTree<64, 256>", keys);
+    run<BufferedBPlusTree<int, long, 64, 1024>>("BufferedBPlusTree<64, 1024>", keys);
+    run<BufferedBPlusTree<int, long, 16, 1024>>("BufferedBPlusTree<16, 1024>", keys);
+}
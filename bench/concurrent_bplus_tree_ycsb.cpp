@@ -0,0 +1,90 @@
+// YCSB-style mix on ConcurrentBPlusTree against BPlusTree behind one std::mutex: the tree is
+// preloaded, then ops uniform operations are split over the threads. A read looks up a random
+// preloaded key, an insert adds a new key. Thread counts double from 1 up to max threads.
+// Needs -pthread.
+//     ./concurrent_bplus_tree_ycsb [max threads = hardware threads] [preload = 1000000] [ops = 4000000]
+#include "Bench.hpp"
+#include "BPlusTree.hpp"
+#include "ConcurrentBPlusTree.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// What ConcurrentBPlusTree replaces
+class LockedTree {
+public:
+    void insert(int64_t x, int64_t value) {
+        std::lock_guard<std::mutex> guard(lock);
+        tree.insert(x, value);
+    }
+    bool find(int64_t x, int64_t& value) {
+        std::lock_guard<std::mutex> guard(lock);
+        int64_t* found = tree.find(x);
+        if (found != nullptr) {
+            value = *found;
+        }
+        return found != nullptr;
+    }
+private:
+    std::mutex lock;
+    BPlusTree<int64_t, int64_t, 64> tree;
+};
+
+// Mops/s; hits counts the reads that found their key
+template <typename Tree>
+double run(Tree& tree, long preload, long ops, int threads, int read_percent, long& hits) {
+    std::vector<std::thread> workers;
+    std::vector<long> found(threads, 0);
+    long per_thread = ops / threads;
+    Timer timer;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::vector<uint64_t> draws = randomKeys<uint64_t>(per_thread, 0, 210 + t);
+            int64_t next_key = preload + t;     // Threads insert disjoint new keys
+            for (uint64_t draw : draws) {
+                if (static_cast<int>(draw % 100) < read_percent) {
+                    int64_t value;
+                    found[t] += tree.find(static_cast<int64_t>(draw / 100 % preload) * 2, value);
+                } else {
+                    tree.insert(next_key * 2, next_key);
+                    next_key += threads;
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = timer.seconds();
+    for (long f : found) {
+        hits += f;
+    }
+    return per_thread * threads / seconds / 1e6;
+}
+
+int main(int argc, char** argv) {
+    int max_threads = argOr(argc, argv, 1, std::max(1u, std::thread::hardware_concurrency()));
+    long preload = argOr(argc, argv, 2, 1000000);
+    long ops = argOr(argc, argv, 3, 4000000);
+
+    printf("preload %ld, ops %ld, Mops/s\n", preload, ops);
+    printf("threads   reads   mutex   concurrent\n");
+    for (int read_percent : {95, 50}) {
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            LockedTree locked;
+            ConcurrentBPlusTree<int64_t, int64_t, 64> concurrent;
+            for (long i = 0; i < preload; i++) {
+                locked.insert(i * 2, i);
+                concurrent.insert(i * 2, i);
+            }
+            long locked_hits = 0, concurrent_hits = 0;
+            double locked_rate = run(locked, preload, ops, threads, read_percent, locked_hits);
+            double concurrent_rate = run(concurrent, preload, ops, threads, read_percent, concurrent_hits);
+            printf("%7d   %4d%%   %5.2f   %10.2f\n", threads, read_percent, locked_rate, concurrent_rate);
+            if (locked_hits != concurrent_hits) {
+                printf("reads found %ld keys in the mutex tree but %ld in the concurrent one\n", locked_hits, concurrent_hits);
+            }
+        }
+    }
+}
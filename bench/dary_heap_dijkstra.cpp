@@ -0,0 +1,35 @@
+// Dijkstra with decrease-key on DaryHeap (D = 2, 4, 8) against PairHeap and FibonacciHeap,
+// on a random graph and on a grid.
+//     ./dary_heap_dijkstra [vertices = 1000000] [degree = 8] [grid width = 1000]
+#include "Bench.hpp"
+#include "Graph.hpp"
+#include "DaryHeap.hpp"
+#include "PairHeap.hpp"
+#include "FibonacciHeap.hpp"
+#include <cstdio>
+
+template <typename Heap>
+void run(const char* name, const Graph& g) {
+    Timer timer;
+    uint64_t check = dijkstra<Heap>(g);
+    printf("  %-16s %6.3f s  check %llu\n", name, timer.seconds(), static_cast<unsigned long long>(check));
+}
+
+void runAll(const Graph& g) {
+    run<DaryHeap<uint64_t, 2>>("DaryHeap<2>", g);
+    run<DaryHeap<uint64_t, 4>>("DaryHeap<4>", g);
+    run<DaryHeap<uint64_t, 8>>("DaryHeap<8>", g);
+    run<PairHeap<uint64_t>>("PairHeap", g);
+    run<FibonacciHeap<uint64_t>>("FibonacciHeap", g);
+}
+
+int main(int argc, char** argv) {
+    int vertices = argOr(argc, argv, 1, 1000000);
+    int degree = argOr(argc, argv, 2, 8);
+    int width = argOr(argc, argv, 3, 1000);
+
+    printf("random graph, %d vertices, %d edges each\n", vertices, degree);
+    runAll(randomGraph(vertices, degree, 1000, 10));
+    printf("grid, %d x %d\n", width, width);
+    runAll(gridGraph(width, 100, 10));
+}
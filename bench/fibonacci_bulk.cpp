@@ -0,0 +1,47 @@
+// Loading a FibonacciHeap and draining its k smallest keys: a loop of push() and pop() against
+// the range constructor and pop_k().
+//     ./fibonacci_bulk [keys = 3000000] [k = 1000]
+#include "Bench.hpp"
+#include "FibonacciHeap.hpp"
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    long count = argOr(argc, argv, 1, 3000000);
+    int k = argOr(argc, argv, 2, 1000);
+    std::vector<int> keys = randomKeys<int>(count, 0, 6);
+    std::vector<int> drained(k);
+
+    printf("keys %ld, k %d\n", count, k);
+    for (int round = 0; round < 3; round++) {
+        long check = 0;
+        Timer timer;
+        {
+            FibonacciHeap<int> heap;
+            for (int key : keys) {
+                heap.push(key);
+            }
+            double load = timer.seconds();
+            for (int i = 0; i < k; i++) {
+                drained[i] = heap.pop();
+            }
+            double drain = timer.seconds() - load;
+            for (int key : drained) {
+                check += key;
+            }
+            printf("push + pop          load %.3f s  drain %.3f s  check %ld\n", load, drain, check);
+        }
+
+        check = 0;
+        timer.reset();
+        {
+            FibonacciHeap<int> heap(keys.begin(), keys.end());
+            double load = timer.seconds();
+            heap.pop_k(k, drained.begin());
+            double drain = timer.seconds() - load;
+            for (int key : drained) {
+                check += key;
+            }
+            printf("range + pop_k       load %.3f s  drain %.3f s  check %ld\n", load, drain, check);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+// Per-operation latency of FibonacciHeap with full consolidation in pop() (budget 0) against
+// bounded consolidation (setConsolidationBudget). The heap is preloaded with pushes only, so the
+// first pop() meets the whole root list; then two pushes per pop are timed one by one.
+// All nodes are allocated up front, a push that grows the node pool would stall as well.
+//     ./fibonacci_latency [preload = 1000000] [ops = 2000000] [budget = 32]
+#include "Bench.hpp"
+#include "FibonacciHeap.hpp"
+#include <algorithm>
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    long preload = argOr(argc, argv, 1, 1000000);
+    long ops = argOr(argc, argv, 2, 2000000);
+    int budget = argOr(argc, argv, 3, 32);
+    std::vector<int> keys = randomKeys<int>(preload + ops, 1u << 30, 4);
+
+    printf("preload %ld, ops %ld, latency in us; the histogram counts ops of < 1, < 2, < 4 ... us\n", preload, ops);
+    for (int steps : {0, budget}) {
+        FibonacciHeap<int> heap(preload + ops);
+        heap.setConsolidationBudget(steps);
+        for (long i = 0; i < preload; i++) {
+            heap.push(keys[i]);
+        }
+        std::vector<double> latency(ops);
+        long check = 0;
+        Timer total;
+        for (long i = 0; i < ops; i++) {
+            Timer timer;
+            if (i % 3 == 2) {
+                check += heap.pop();
+            } else {
+                heap.push(keys[preload + i]);
+            }
+            latency[i] = timer.seconds() * 1e6;
+        }
+        double seconds = total.seconds();
+
+        std::vector<long> histogram;
+        for (double us : latency) {
+            size_t bucket = 0;
+            while (us >= (1 << bucket)) {
+                bucket++;
+            }
+            histogram.resize(std::max(histogram.size(), bucket + 1));
+            histogram[bucket]++;
+        }
+        std::sort(latency.begin(), latency.end());
+        printf("budget %3d  total %.3f s  p50 %.2f  p99 %.2f  p99.9 %.2f  max %.1f  check %ld\n  histogram",
+            steps, seconds, latency[ops / 2], latency[ops * 99 / 100], latency[ops * 999 / 1000], latency.back(), check);
+        for (long count : histogram) {
+            printf(" %ld", count);
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,35 @@
+// Peek-heavy mixes on FibonacciHeap: every push is followed by `peeks` calls to top(), and every
+// other push by a pop(). top() reads the kept minimum; before that it consolidated the root list.
+// The driver only uses push, top and pop, so it also builds against the FibonacciHeap.hpp that
+// precedes the change (git show e5b2c61^:FibonacciHeap.hpp) for the numbers before it.
+//     ./fibonacci_top [preload = 1000000] [steps = 2000000]
+#include "Bench.hpp"
+#include "FibonacciHeap.hpp"
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    long preload = argOr(argc, argv, 1, 1000000);
+    long steps = argOr(argc, argv, 2, 2000000);
+    std::vector<int> keys = randomKeys<int>(preload + steps, 1u << 30, 1);
+
+    printf("preload %ld, steps %ld\n", preload, steps);
+    for (int peeks : {0, 1, 4, 16}) {
+        FibonacciHeap<int> heap;
+        for (long i = 0; i < preload; i++) {
+            heap.push(keys[i]);
+        }
+        heap.pop();     // Consolidate once, so every mix starts from the same shape
+        long check = 0;
+        Timer timer;
+        for (long i = 0; i < steps; i++) {
+            heap.push(keys[preload + i]);
+            for (int p = 0; p < peeks; p++) {
+                check += heap.top();
+            }
+            if (i % 2) {
+                check += heap.pop();
+            }
+        }
+        printf("%2d peeks per push   %6.3f s   check %ld\n", peeks, timer.seconds(), check);
+    }
+}
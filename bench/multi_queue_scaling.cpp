@@ -0,0 +1,86 @@
+// Thread scaling of MultiQueue against one PairHeap behind a std::mutex. The queue is preloaded,
+// then every thread alternates push() of a random key and pop() until ops have been done in all.
+// Thread counts double from 1 up to max threads. Needs -pthread.
+//     ./multi_queue_scaling [max threads = hardware threads] [ops = 4000000] [shards per thread = 2] [choices = 2]
+#include "Bench.hpp"
+#include "MultiQueue.hpp"
+#include "PairHeap.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// One PairHeap under a global lock, what MultiQueue replaces
+class LockedHeap {
+public:
+    void push(int key) {
+        std::lock_guard<std::mutex> guard(lock);
+        heap.push(key);
+    }
+    bool pop(int& key) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (heap.empty()) {
+            return false;
+        }
+        key = heap.pop();
+        return true;
+    }
+private:
+    std::mutex lock;
+    PairHeap<int> heap;
+};
+
+// Mops/s of ops push/pop pairs split over threads; popped counts the keys that came out
+template <typename Queue>
+double run(Queue& queue, int threads, long ops, long& popped) {
+    std::vector<std::thread> workers;
+    std::vector<long> pops(threads, 0);
+    Timer timer;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::vector<int> keys = randomKeys<int>(ops / threads, 1u << 30, 100 + t);
+            for (int key : keys) {
+                queue.push(key);
+                int out;
+                pops[t] += queue.pop(out);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = timer.seconds();
+    for (long p : pops) {
+        popped += p;
+    }
+    return 2.0 * (ops / threads) * threads / seconds / 1e6;
+}
+
+int main(int argc, char** argv) {
+    int max_threads = argOr(argc, argv, 1, std::max(1u, std::thread::hardware_concurrency()));
+    long ops = argOr(argc, argv, 2, 4000000);
+    int shards_per_thread = argOr(argc, argv, 3, 2);
+    int choices = argOr(argc, argv, 4, 2);
+    std::vector<int> preload = randomKeys<int>(1000000, 1u << 30, 11);
+
+    printf("ops %ld, MultiQueue with %d shards per thread and %d choices\n", ops, shards_per_thread, choices);
+    printf("threads   mutex Mops/s   MultiQueue Mops/s   lock failures   empty probes\n");
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        long mutex_popped = 0, multi_popped = 0;
+        LockedHeap locked;
+        MultiQueue<int> multi(threads, shards_per_thread, choices);
+        for (int key : preload) {
+            locked.push(key);
+            multi.push(key);
+        }
+        multi.resetCounters();
+        double mutex_rate = run(locked, threads, ops, mutex_popped);
+        double multi_rate = run(multi, threads, ops, multi_popped);
+        MultiQueue<int>::Counters counters = multi.getCounters();
+        printf("%7d   %12.2f   %17.2f   %13llu   %12llu\n", threads, mutex_rate, multi_rate,
+            static_cast<unsigned long long>(counters.lock_failures), static_cast<unsigned long long>(counters.empty_probes));
+        if (mutex_popped != multi_popped) {
+            printf("popped %ld keys from the mutex heap but %ld from MultiQueue\n", mutex_popped, multi_popped);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+// PackedBPlusTree against BPlusTree on 64-bit ids with gaps of 1 to 8: insert time, bytes per key
+// (getBytes() over the key count, so values, pointers and slack are included), scan throughput
+// over 5 full iterations, and random lookups of present keys. The ids are inserted mostly sorted
+// (shuffled within blocks of 64), then in random order.
+//     ./packed_bplus_tree [keys = 10000000]
+#include "Bench.hpp"
+#include "BPlusTree.hpp"
+#include "PackedBPlusTree.hpp"
+#include <algorithm>
+#include <cstdio>
+
+template <typename Tree>
+void run(const char* name, const std::vector<int64_t>& keys, const std::vector<int64_t>& probes) {
+    Tree tree;
+    Timer timer;
+    for (size_t i = 0; i < keys.size(); i++) {
+        tree.insert(keys[i], static_cast<uint32_t>(i));
+    }
+    double insert = timer.seconds();
+
+    uint64_t check = 0;
+    timer.reset();
+    for (int pass = 0; pass < 5; pass++) {
+        for (auto pair : tree) {
+            check += pair.first + pair.second;
+        }
+    }
+    double scan = timer.seconds();
+
+    timer.reset();
+    for (int64_t key : probes) {
+        uint32_t* value = tree.find(key);
+        check += value ? *value : 0;
+    }
+    double find = timer.seconds();
+    printf("  %-22s insert %5.2f s  %5.2f B/key  scan %4.0f Mkeys/s  find %5.2f s  check %llu\n", name, insert,
+        static_cast<double>(tree.getBytes()) / keys.size(), 5 * keys.size() / scan / 1e6, find,
+        static_cast<unsigned long long>(check));
+}
+
+void runAll(const std::vector<int64_t>& keys, const std::vector<int64_t>& probes) {
+    run<BPlusTree<int64_t, uint32_t, 64>>("BPlusTree<64>", keys, probes);
+    run<PackedBPlusTree<int64_t, uint32_t, 64, 256, 16>>("Packed<64, 256, 16>", keys, probes);
+    run<PackedBPlusTree<int64_t, uint32_t, 64, 512, 8>>("Packed<64, 512, 8>", keys, probes);
+}
+
+int main(int argc, char** argv) {
+    long count = argOr(argc, argv, 1, 10000000);
+    std::vector<uint64_t> draws = randomKeys<uint64_t>(2 * count, 0, 25);
+    std::vector<int64_t> sorted(count);
+    int64_t id = int64_t(1) << 40;
+    for (long i = 0; i < count; i++) {
+        id += 1 + draws[i] % 8;
+        sorted[i] = id;
+    }
+    std::vector<int64_t> probes(count);
+    for (long i = 0; i < count; i++) {
+        probes[i] = sorted[draws[count + i] % count];
+    }
+
+    std::mt19937_64 gen(26);
+    std::vector<int64_t> keys = sorted;
+    for (long i = 0; i + 64 <= count; i += 64) {
+        std::shuffle(keys.begin() + i, keys.begin() + i + 64, gen);
+    }
+    printf("%ld ids, mostly sorted\n", count);
+    runAll(keys, probes);
+    std::shuffle(keys.begin(), keys.end(), gen);
+    printf("%ld ids, random order\n", count);
+    runAll(keys, probes);
+}
@@ -0,0 +1,39 @@
+// Dijkstra with decrease-key on RadixHeap, picked through PriorityQueue<uint64_t, true>, against
+// DaryHeap, PairHeap and FibonacciHeap, on a random graph and on a grid. Distances only grow
+// during Dijkstra, so the packed keys are a monotone use of the radix heap.
+//     ./radix_heap_dijkstra [vertices = 1000000] [degree = 8] [grid width = 1000]
+#include "Bench.hpp"
+#include "Graph.hpp"
+#include "RadixHeap.hpp"
+#include "DaryHeap.hpp"
+#include "PairHeap.hpp"
+#include "FibonacciHeap.hpp"
+#include <cstdio>
+#include <type_traits>
+
+static_assert(std::is_same<PriorityQueue<uint64_t, true>, RadixHeap<uint64_t>>::value, "Monotone uint64_t keys should get RadixHeap");
+
+template <typename Heap>
+void run(const char* name, const Graph& g) {
+    Timer timer;
+    uint64_t check = dijkstra<Heap>(g);
+    printf("  %-16s %6.3f s  check %llu\n", name, timer.seconds(), static_cast<unsigned long long>(check));
+}
+
+void runAll(const Graph& g) {
+    run<PriorityQueue<uint64_t, true>>("RadixHeap", g);
+    run<DaryHeap<uint64_t, 4>>("DaryHeap<4>", g);
+    run<PairHeap<uint64_t>>("PairHeap", g);
+    run<FibonacciHeap<uint64_t>>("FibonacciHeap", g);
+}
+
+int main(int argc, char** argv) {
+    int vertices = argOr(argc, argv, 1, 1000000);
+    int degree = argOr(argc, argv, 2, 8);
+    int width = argOr(argc, argv, 3, 1000);
+
+    printf("random graph, %d vertices, %d edges each\n", vertices, degree);
+    runAll(randomGraph(vertices, degree, 1000, 12));
+    printf("grid, %d x %d\n", width, width);
+    runAll(gridGraph(width, 100, 12));
+}